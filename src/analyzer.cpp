@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "analyzer.h"
+#include "profiler.h"
+
+namespace {
+    // LRU stack distances: a Fenwick tree marks the time of the last access to every block, so the distinct
+    // blocks touched since a block's last access are the marks after it. Times are renumbered once the tree
+    // fills up, which keeps it proportional to the number of distinct blocks rather than to the trace length.
+    class ReuseDistance {
+    public:
+        // distinct other blocks touched since the last access to block, or -1 on its first access
+        long long access(uint32_t block) {
+            if (now == static_cast<long long>(tree.size())) compact();
+
+            long long distance = -1;
+            auto last_access = last.find(block);
+            if (last_access != last.end()) {
+                distance = static_cast<long long>(last.size()) - prefix(last_access->second);
+                add(last_access->second, -1);
+                last_access->second = now;
+            } else {
+                last.emplace(block, now);
+            }
+            add(now, 1);
+            now++;
+            return distance;
+        }
+
+        ReuseDistance() : now(0), tree(Config::ANALYSIS_WINDOW, 0) {}
+    private:
+        // marks at times <= time
+        long long prefix(long long time) const {
+            long long sum = 0;
+            for (long long i = time + 1; i > 0; i -= i & -i) sum += tree[i - 1];
+            return sum;
+        }
+
+        void add(long long time, int delta) {
+            for (long long i = time + 1; i <= static_cast<long long>(tree.size()); i += i & -i) tree[i - 1] += delta;
+        }
+
+        // renumber the last accesses 0, 1, ... in order and leave as much room again for new accesses
+        void compact() {
+            std::vector<std::pair<long long, uint32_t>> order;
+            order.reserve(last.size());
+            for (const auto& [block, time] : last) order.emplace_back(time, block);
+            std::sort(order.begin(), order.end());
+
+            tree.assign(std::max<size_t>(2 * order.size(), Config::ANALYSIS_WINDOW), 0);
+            for (size_t i = 0; i < order.size(); i++) {
+                last[order[i].second] = static_cast<long long>(i);
+                add(static_cast<long long>(i), 1);
+            }
+            now = static_cast<long long>(order.size());
+        }
+
+        long long now;
+        std::vector<int> tree;
+        std::unordered_map<uint32_t, long long> last;
+    };
+}
+
+TraceAnalyzer::TraceAnalyzer(int block_size, int cache_size, long long _window)
+        : offset_bits(static_cast<int>(std::log2(block_size))), cache_blocks(cache_size / block_size),
+          window(_window), footprint(Config::ANALYSIS_HLL_PRECISION) {}
+
+CoreAnalysis TraceAnalyzer::analyze_core(Trace& trace) const {
+    CoreAnalysis core;
+    ReuseDistance reuse;
+    HyperLogLog working_set(Config::ANALYSIS_HLL_PRECISION);
+    long long in_window = 0;
+
+    while (trace.has_next_instruction()) {
+        const Instruction& ins = trace.get_current_instruction();
+        if (!is_memory_access(ins.type)) continue;
+
+        uint32_t block = static_cast<uint32_t>(ins.value) >> offset_bits;
+        BlockUsage& usage = core.blocks[block];
+        core.accesses++;
+        // an atomic reads and writes its block
+        if (ins.type != STORE) {
+            core.reads++;
+            usage.reads++;
+        }
+        if (ins.type != LOAD) {
+            core.writes++;
+            usage.writes++;
+        }
+
+        long long distance = reuse.access(block);
+        if (distance < 0) {
+            core.cold_accesses++;
+        } else {
+            size_t bucket = std::bit_width(static_cast<unsigned long long>(distance));
+            if (core.reuse_histogram.size() <= bucket) core.reuse_histogram.resize(bucket + 1, 0);
+            core.reuse_histogram[bucket]++;
+            if (distance < cache_blocks) core.within_cache++;
+        }
+
+        core.footprint.add(block);
+        working_set.add(block);
+        if (++in_window == window) {
+            core.window_working_sets.push_back(working_set.estimate());
+            working_set.clear();
+            in_window = 0;
+        }
+    }
+    // a trace shorter than one window still gets its working set
+    if (core.window_working_sets.empty() && in_window > 0) core.window_working_sets.push_back(working_set.estimate());
+    return core;
+}
+
+void TraceAnalyzer::run(const std::vector<Trace*>& traces) {
+    cores.assign(traces.size(), CoreAnalysis());
+    footprint.clear();
+    shared_blocks.clear();
+    std::mutex merge_mtx;
+    std::vector<std::thread> threads;
+    threads.reserve(traces.size());
+    for (size_t j = 0; j < traces.size(); j++) {
+        threads.emplace_back([this, j, &traces, &merge_mtx]() {
+            CoreAnalysis core = analyze_core(*traces[j]);
+            // the counts are sums, so the cores can be merged in the order they finish
+            std::lock_guard<std::mutex> lock(merge_mtx);
+            merge(core);
+            cores[j] = std::move(core);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    summarize();
+}
+
+void TraceAnalyzer::merge(CoreAnalysis& core) {
+    footprint.merge(core.footprint);
+    for (const auto& [block, usage] : core.blocks) {
+        SharedBlock& shared = shared_blocks[block];
+        shared.sharers++;
+        if (usage.writes > 0) shared.writers++;
+        shared.reads += usage.reads;
+        shared.writes += usage.writes;
+    }
+    std::unordered_map<uint32_t, BlockUsage>().swap(core.blocks);
+}
+
+void TraceAnalyzer::summarize() {
+    global = GlobalAnalysis();
+    global.blocks = static_cast<long long>(shared_blocks.size());
+    global.by_sharers.assign(cores.size() + 1, 0);
+    for (const auto& [block, shared] : shared_blocks) {
+        global.by_sharers[shared.sharers]++;
+        if (shared.sharers > 1) {
+            if (shared.writers == 0) global.shared_read_only++;
+            else global.shared_read_write++;
+        }
+        global.reads += shared.reads;
+        global.writes += shared.writes;
+
+        long long accesses = shared.reads + shared.writes;
+        if (shared.writes == 0) global.read_only++;
+        else if (shared.reads == 0) global.write_only++;
+        else if (shared.reads * 4 >= accesses * 3) global.mostly_read++;
+        else if (shared.writes * 4 >= accesses * 3) global.mostly_written++;
+        else global.mixed++;
+    }
+    std::unordered_map<uint32_t, SharedBlock>().swap(shared_blocks);
+}
+
+void TraceAnalyzer::print() const {
+    for (size_t j = 0; j < cores.size(); j++) {
+        const CoreAnalysis& core = cores[j];
+        std::cout << "[Core " << j << "]" << std::endl;
+        std::cout << "Accesses: " << core.accesses << " (" << core.reads << " reads, " << core.writes << " writes)" << std::endl;
+        std::cout << "Distinct blocks (estimate): " << static_cast<long long>(core.footprint.estimate()) << std::endl;
+        std::cout << "Reuse distances (distinct blocks in between):" << std::endl;
+        Profiler::print_percentage("  cold", core.cold_accesses, core.accesses);
+        for (size_t bucket = 0; bucket < core.reuse_histogram.size(); bucket++) {
+            if (core.reuse_histogram[bucket] == 0) continue;
+            long long low = bucket == 0 ? 0 : 1LL << (bucket - 1);
+            long long high = bucket == 0 ? 0 : (1LL << bucket) - 1;
+            std::string label = low == high ? std::to_string(low) : std::to_string(low) + "-" + std::to_string(high);
+            Profiler::print_percentage("  " + label, core.reuse_histogram[bucket], core.accesses);
+        }
+        Profiler::print_percentage("Reuse within a " + std::to_string(cache_blocks) + "-block LRU cache",
+                                   core.within_cache, core.accesses);
+        if (!core.window_working_sets.empty()) {
+            const std::vector<double>& sets = core.window_working_sets;
+            double mean = 0;
+            for (double set : sets) mean += set;
+            mean /= static_cast<double>(sets.size());
+            std::cout << "Working set per " << window << " accesses (blocks): min "
+                      << static_cast<long long>(*std::min_element(sets.begin(), sets.end()))
+                      << ", mean " << static_cast<long long>(mean)
+                      << ", max " << static_cast<long long>(*std::max_element(sets.begin(), sets.end()))
+                      << " over " << sets.size() << " windows" << std::endl;
+        }
+    }
+
+    std::cout << std::endl << "[Global]" << std::endl;
+    const long long blocks = global.blocks;
+    std::cout << "Distinct blocks: " << blocks << " (estimate " << static_cast<long long>(footprint.estimate()) << ")" << std::endl;
+
+    std::cout << "Blocks by sharing degree:" << std::endl;
+    for (size_t sharers = 1; sharers < global.by_sharers.size(); sharers++) {
+        Profiler::print_percentage("  " + std::to_string(sharers) + (sharers == 1 ? " core" : " cores"),
+                                   global.by_sharers[sharers], blocks);
+    }
+    Profiler::print_percentage("Shared read-only blocks", global.shared_read_only, blocks);
+    Profiler::print_percentage("Shared read-write blocks", global.shared_read_write, blocks);
+    std::cout << "Blocks by read / write mix:" << std::endl;
+    Profiler::print_percentage("  read-only", global.read_only, blocks);
+    Profiler::print_percentage("  mostly read (>= 75% reads)", global.mostly_read, blocks);
+    Profiler::print_percentage("  mixed", global.mixed, blocks);
+    Profiler::print_percentage("  mostly written (>= 75% writes)", global.mostly_written, blocks);
+    Profiler::print_percentage("  write-only", global.write_only, blocks);
+    std::cout << "Read / write ratio: "
+              << (global.writes == 0 ? 0.0 : static_cast<double>(global.reads) / global.writes) << std::endl;
+}
@@ -0,0 +1,89 @@
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "config.h"
+#include "hyperloglog.h"
+#include "trace.h"
+
+// accesses of one core to one block
+struct BlockUsage {
+    uint32_t reads = 0;
+    uint32_t writes = 0;
+};
+
+struct CoreAnalysis {
+    long long accesses = 0;
+    long long reads = 0;
+    long long writes = 0;
+    // first touches of a block, which have no reuse distance
+    long long cold_accesses = 0;
+    // bucket 0 counts reuse distance 0, bucket i > 0 distances in [2^(i-1), 2^i)
+    std::vector<long long> reuse_histogram;
+    // accesses whose reuse distance is below the number of blocks of the cache, i.e. hits in a fully
+    // associative LRU cache of that size
+    long long within_cache = 0;
+    // estimated distinct blocks of each full window of accesses
+    std::vector<double> window_working_sets;
+    HyperLogLog footprint{Config::ANALYSIS_HLL_PRECISION};
+    // dropped as soon as the core is merged into the global analysis
+    std::unordered_map<uint32_t, BlockUsage> blocks;
+};
+
+// characterizes traces without simulating them: reuse distances, working sets, sharing and read / write mix
+// per block. Each core's stream is analyzed on its own thread in memory proportional to its distinct blocks,
+// and merged as soon as it is done.
+class TraceAnalyzer {
+public:
+    // analyze the traces, one core each; they are consumed
+    void run(const std::vector<Trace*>& traces);
+    void print() const;
+
+    // block_size and cache_size set the block granularity and the cache the reuse distances are compared to;
+    // working sets are estimated over windows of window accesses
+    TraceAnalyzer(int block_size, int cache_size, long long window);
+private:
+    struct SharedBlock {
+        int sharers = 0;
+        // cores that wrote the block
+        int writers = 0;
+        long long reads = 0;
+        long long writes = 0;
+    };
+
+    // the blocks of all cores, counted once every core is merged
+    struct GlobalAnalysis {
+        long long blocks = 0;
+        // indexed by the number of cores accessing a block
+        std::vector<long long> by_sharers;
+        long long shared_read_only = 0;
+        long long shared_read_write = 0;
+        long long read_only = 0;
+        long long mostly_read = 0;
+        long long mixed = 0;
+        long long mostly_written = 0;
+        long long write_only = 0;
+        long long reads = 0;
+        long long writes = 0;
+    };
+
+    [[nodiscard]] CoreAnalysis analyze_core(Trace& trace) const;
+    // fold the blocks of a core into shared_blocks, then drop them
+    void merge(CoreAnalysis& core);
+    // count the merged blocks into global, then drop them
+    void summarize();
+
+    int offset_bits;
+    long long cache_blocks;
+    long long window;
+    std::vector<CoreAnalysis> cores;
+    // only held while the cores are merged
+    std::unordered_map<uint32_t, SharedBlock> shared_blocks;
+    GlobalAnalysis global;
+    HyperLogLog footprint;
+};
+
+#endif //ANALYZER_H
@@ -0,0 +1,113 @@
+#include "buffer_trace.h"
+
+SpanTrace::SpanTrace(std::span<const Instruction> _instructions) : instructions(_instructions), position(0) {}
+
+const Instruction& SpanTrace::get_current_instruction() {
+    if (position < instructions.size()) {
+        return instructions[position++];
+    } else {
+        throw std::out_of_range("No further instructions available.");
+    }
+}
+
+bool SpanTrace::has_next_instruction() const {
+    return position < instructions.size();
+}
+
+TraceMarkers SpanTrace::get_markers() const {
+    return find_markers(instructions.data(), instructions.size());
+}
+
+std::span<const std::byte> SpanTrace::get_storage() const {
+    return std::as_bytes(instructions);
+}
+
+BatchTrace::BatchTrace(BatchSource _source, int _core_id, TraceMarkers _markers)
+        : source(std::move(_source)), core_id(_core_id), markers(_markers), position(0), ended(false) {}
+
+void BatchTrace::refill() const {
+    while (!ended && position == batch.size()) {
+        batch = source(core_id);
+        position = 0;
+        if (batch.empty()) ended = true;
+    }
+}
+
+const Instruction& BatchTrace::get_current_instruction() {
+    refill();
+    if (ended) {
+        throw std::out_of_range("No further instructions available.");
+    }
+    return batch[position++];
+}
+
+bool BatchTrace::has_next_instruction() const {
+    refill();
+    return !ended;
+}
+
+TraceMarkers BatchTrace::get_markers() const {
+    return markers;
+}
+
+BatchQueue::BatchQueue(size_t _capacity) : capacity(_capacity), closed(false) {}
+
+void BatchQueue::push(std::span<const Instruction> batch) {
+    if (batch.empty()) return;
+    std::vector<Instruction> copy(batch.begin(), batch.end());
+    std::unique_lock<std::mutex> lock(mtx);
+    changed.wait(lock, [this]() { return batches.size() < capacity; });
+    batches.push_back(std::move(copy));
+    changed.notify_all();
+}
+
+void BatchQueue::close() {
+    std::lock_guard<std::mutex> lock(mtx);
+    closed = true;
+    changed.notify_all();
+}
+
+std::span<const Instruction> BatchQueue::pop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    changed.wait(lock, [this]() { return !batches.empty() || closed; });
+    if (batches.empty()) return {};
+    current = std::move(batches.front());
+    batches.pop_front();
+    changed.notify_all();
+    return current;
+}
+
+StreamTrace::StreamTrace(const std::string& filename) : infile(filename), line_number(0), has_next(false) {
+    if (!infile) {
+        std::cerr << "Error: Unable to open file '" << filename << "'." << std::endl;
+        return;
+    }
+    advance();
+}
+
+void StreamTrace::advance() {
+    has_next = false;
+    std::string line;
+    while (std::getline(infile, line)) {
+        line_number++;
+        if (parse_line(line, line_number, next)) {
+            has_next = true;
+            return;
+        }
+    }
+}
+
+const Instruction& StreamTrace::get_current_instruction() {
+    if (!has_next) throw std::out_of_range("No further instructions available.");
+    current = next;
+    advance();
+    return current;
+}
+
+bool StreamTrace::has_next_instruction() const {
+    return has_next;
+}
+
+bool StreamTrace::is_open() const {
+    return infile.is_open();
+}
@@ -0,0 +1,96 @@
+#ifndef BUFFER_TRACE_H
+#define BUFFER_TRACE_H
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "trace.h"
+
+// returns the next batch of instructions of a core, or an empty span once its trace has ended;
+// a batch is read in place and must stay valid until the next call for the same core
+using BatchSource = std::function<std::span<const Instruction>(int core_id)>;
+
+// batches of a core pushed by the caller while the simulation runs: push waits while the queue is full and the
+// core waits for the next batch while it is empty, so a producer feeding several cores has to keep them in step
+class BatchQueue {
+public:
+    // copy a batch into the queue, waiting while it holds capacity batches; empty batches are dropped
+    void push(std::span<const Instruction> batch);
+    // end the trace: the core finishes once it has run the batches already pushed
+    void close();
+    // the next batch, valid until the next call, or an empty span once the queue is closed and drained
+    std::span<const Instruction> pop();
+
+    explicit BatchQueue(size_t _capacity);
+private:
+    std::mutex mtx;
+    std::condition_variable changed;
+    size_t capacity;
+    std::deque<std::vector<Instruction>> batches;
+    // the batch the core is running
+    std::vector<Instruction> current;
+    bool closed;
+};
+
+// a trace read in place from a caller-owned buffer, which must outlive the simulation
+class SpanTrace : public Trace {
+public:
+    const Instruction& get_current_instruction() override;
+    bool has_next_instruction() const override;
+    TraceMarkers get_markers() const override;
+    std::span<const std::byte> get_storage() const override;
+
+    explicit SpanTrace(std::span<const Instruction> _instructions);
+private:
+    std::span<const Instruction> instructions;
+    size_t position;
+};
+
+// a trace pulled batch by batch from a callback, so the caller never materializes the whole trace; the
+// batches cannot be searched before they run, so the markers they hold are declared up front
+class BatchTrace : public Trace {
+public:
+    const Instruction& get_current_instruction() override;
+    bool has_next_instruction() const override;
+    TraceMarkers get_markers() const override;
+
+    BatchTrace(BatchSource _source, int _core_id, TraceMarkers _markers = TraceMarkers());
+private:
+    // fetch batches until one is not empty or the source has ended
+    void refill() const;
+
+    BatchSource source;
+    int core_id;
+    TraceMarkers markers;
+    // the batch is fetched lazily from has_next_instruction
+    mutable std::span<const Instruction> batch;
+    mutable size_t position;
+    mutable bool ended;
+};
+
+// a trace file read one line at a time instead of all at once, for passes over traces larger than memory
+class StreamTrace : public Trace {
+public:
+    const Instruction& get_current_instruction() override;
+    bool has_next_instruction() const override;
+    // false if the file cannot be opened
+    [[nodiscard]] bool is_open() const;
+
+    explicit StreamTrace(const std::string& filename);
+private:
+    // read ahead to the next instruction, if any
+    void advance();
+
+    std::ifstream infile;
+    int line_number;
+    Instruction next;
+    Instruction current;
+    bool has_next;
+};
+
+#endif // BUFFER_TRACE_H
@@ -1,28 +1,52 @@
 #include "bus.h"
 #include "memory.h"
+#include "dram.h"
+#include "mesh.h"
+#include "config.h"
 
-Bus::Bus(int _block_size) : total_invalidations_updates(0), total_traffic(0), block_size(_block_size) {}
+Bus::Bus(int _block_size) : total_invalidations_updates(0), total_traffic(0), block_size(_block_size), transfer_size(_block_size), uniform_geometry(true),
+        memory_controller(nullptr), mesh(nullptr), mem_fetch_time(Config::MEM_FETCH_TIME), mem_flush_time(Config::MEM_FLUSH_TIME) {}
 
 BusResponse Bus::broadcast(BusMessage message, uint32_t address, int sender_idx, CacheState sender_cache_state) {
     // std::lock_guard<std::mutex> lock(mtx);
 
+    // transactions of a core running in the fast mode still reach the other caches but are not counted
+    const int count = memory_blocks[sender_idx]->is_profiling() ? 1 : 0;
+
     if (message == WriteBack) {
         // Cache block is written back to memory
-        total_traffic++;
+        total_traffic += count;
         return NoResponse;
     }
 
     if (message == BusUpdate) {
         // Dragon: Cache block is sent to other caches
-        total_traffic++;
+        total_traffic += count;
     }
 
+    // when all caches share one geometry the address is decomposed once for every receiver; caches of
+    // different sizes or associativities index the block differently, so each receiver decomposes it itself
+    uint32_t offset, set_index, tag;
+    std::tie(offset, set_index, tag) = memory_blocks[sender_idx]->compute_tag_idx_offset(address);
+
     BusResponse orSharedResponses = NoResponse;
     BusResponse orDirtyResponses = NoResponse;
+    int responder = -1;
+    int responder_hops = 0;
     for (int i = 0; i < memory_blocks.size(); i++) {
         // broadcast to other memory blocks apart from sender
         if (i == sender_idx) continue;
-        BusResponse thisResponse = memory_blocks[i]->process_signal_from_bus(message, address, this);
+        if (!uniform_geometry) std::tie(offset, set_index, tag) = memory_blocks[i]->compute_tag_idx_offset(address);
+        BusResponse thisResponse = memory_blocks[i]->process_signal_from_bus(message, address, set_index, tag, this);
+
+        if (mesh != nullptr && thisResponse != NoResponse) {
+            const bool is_read = message == Read || message == ReadDragon;
+            const int hops = mesh->get_hops(mesh->get_tile(sender_idx), mesh->get_tile(i));
+            if (responder < 0 || (is_read ? hops < responder_hops : hops > responder_hops)) {
+                responder = i;
+                responder_hops = hops;
+            }
+        }
 
         if (thisResponse == BusResponseShared) {
             // this cache block is also in another clean cache
@@ -36,34 +60,37 @@ BusResponse Bus::broadcast(BusMessage message, uint32_t address, int sender_idx,
 
         if (message == BusUpdate) {
             // Dragon: BusUpd updates other copies
-            total_invalidations_updates++;
+            total_invalidations_updates += count;
         }
 
         if (message == ReadExclusive && thisResponse != NoResponse) {
             // MESI: BusReadX invalidates other copies
-            total_invalidations_updates++;
+            total_invalidations_updates += count;
         }
     }
 
+    // only the sender's own thread touches its slot
+    if (mesh != nullptr) responders[sender_idx] = responder;
+
     BusResponse finalResponse = orDirtyResponses == BusResponseDirty ? BusResponseDirty :
                                 orSharedResponses == BusResponseShared ? BusResponseShared :
                                 NoResponse;
 
     if ((message == ReadExclusive || message == Read) && (finalResponse != NoResponse)) {
         // MESI: cache to cache transfer of cache block
-        total_traffic++;
+        total_traffic += count;
     }
 
     if (message == ReadDragon && finalResponse != NoResponse) {
         // Dragon: cache to cache transfer of cache block
-        total_traffic++;
+        total_traffic += count;
     }
 
     return finalResponse;
 }
 
 long Bus::get_total_traffic() const {
-    return total_traffic * block_size;
+    return total_traffic * transfer_size;
     // return total_traffic;
 }
 
@@ -71,6 +98,85 @@ long Bus::get_total_invalidations() const {
     return total_invalidations_updates;
 }
 
+void Bus::set_sector_size(int bytes) {
+    transfer_size = bytes;
+}
+
 void Bus::connect_memory(Memory* mem) {
+    if (!memory_blocks.empty() && mem->get_set_index_bits() != memory_blocks.front()->get_set_index_bits()) {
+        uniform_geometry = false;
+    }
     memory_blocks.push_back(mem);
+    responders.push_back(-1);
+}
+
+void Bus::connect_memory_controller(MemoryController* controller) {
+    memory_controller = controller;
+}
+
+MemoryController* Bus::get_memory_controller() const {
+    return memory_controller;
+}
+
+void Bus::connect_mesh(MeshInterconnect* _mesh) {
+    mesh = _mesh;
+}
+
+MeshInterconnect* Bus::get_mesh() const {
+    return mesh;
+}
+
+void Bus::set_memory_latencies(int fetch_time, int flush_time) {
+    mem_fetch_time = fetch_time;
+    mem_flush_time = flush_time;
+}
+
+int Bus::memory_read(uint32_t block_address, long long cycle) {
+    if (memory_controller == nullptr) return mem_fetch_time;
+    return memory_controller->read(block_address, cycle);
+}
+
+int Bus::memory_write(uint32_t block_address, long long cycle) {
+    if (memory_controller == nullptr) return mem_flush_time;
+    return memory_controller->write(block_address, cycle);
+}
+
+int Bus::memory_fetch_time(uint32_t address, int core, long long cycle) {
+    const uint32_t block_address = address & ~(block_size - 1);
+    if (mesh == nullptr) return memory_read(block_address, cycle);
+
+    // the request goes to the home slice of the block, which reads it from main memory on an LLC miss and
+    // sends it back
+    const int tile = mesh->get_tile(core);
+    const int home = mesh->get_home(block_address);
+    int cycles = mesh->send(tile, home, Config::MESH_CONTROL_BYTES, cycle);
+    if (mesh->has_llc()) cycles += mesh->get_llc_hit_time();
+    if (!mesh->access_llc(block_address)) cycles += memory_read(block_address, cycle + cycles);
+    return cycles + mesh->send(home, tile, transfer_size, cycle + cycles);
+}
+
+int Bus::memory_flush_time(uint32_t address, int core, long long cycle) {
+    const uint32_t block_address = address & ~(block_size - 1);
+    if (mesh == nullptr) return memory_write(block_address, cycle);
+
+    // the block goes to its home slice, which keeps it if there is an LLC (its own write backs to main
+    // memory are off the critical path and not timed) and otherwise writes it to main memory
+    const int tile = mesh->get_tile(core);
+    const int home = mesh->get_home(block_address);
+    int cycles = mesh->send(tile, home, transfer_size, cycle);
+    if (!mesh->has_llc()) return cycles + memory_write(block_address, cycle + cycles);
+    mesh->access_llc(block_address);
+    return cycles + mesh->get_llc_hit_time();
+}
+
+int Bus::cache_transfer_time(uint32_t address, int core, long long cycle) {
+    if (mesh == nullptr || responders[core] < 0) return 0;
+
+    // the home tile of the block forwards the request to the cache that answered it, which replies directly
+    const int tile = mesh->get_tile(core);
+    const int home = mesh->get_home(address & ~(block_size - 1));
+    const int other = mesh->get_tile(responders[core]);
+    int cycles = mesh->send(tile, home, Config::MESH_CONTROL_BYTES, cycle);
+    cycles += mesh->send(home, other, Config::MESH_CONTROL_BYTES, cycle + cycles);
+    return cycles + mesh->send(other, tile, transfer_size, cycle + cycles);
 }
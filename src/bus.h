@@ -7,23 +7,57 @@
 #include "enums.h"
 
 class Memory;
+class MemoryController;
+class MeshInterconnect;
 
 class Bus {
 public:
     BusResponse broadcast(BusMessage message, uint32_t address, int sender_idx, CacheState sender_cache_state);
+    // bytes moved by all transfers: a transfer carries a block, or a sector of a sectored cache
     long get_total_traffic() const;
     long get_total_invalidations() const;
     void connect_memory(Memory* mem);
+    // model main memory with a DRAM controller instead of fixed fetch / flush times
+    void connect_memory_controller(MemoryController* controller);
+    [[nodiscard]] MemoryController* get_memory_controller() const;
+    // route transfers over a mesh with a banked last-level cache instead of the shared bus; the bus still
+    // orders the coherence transactions, the mesh times them
+    void connect_mesh(MeshInterconnect* _mesh);
+    [[nodiscard]] MeshInterconnect* get_mesh() const;
+    // caches are split into sectors of this many bytes, which are transferred on their own
+    void set_sector_size(int bytes);
+    // replace the compiled-in main memory fetch / flush times
+    void set_memory_latencies(int fetch_time, int flush_time);
+    // cycles to fetch a block from main memory for a request of core issued at cycle
+    int memory_fetch_time(uint32_t address, int core, long long cycle);
+    // cycles to flush a block to main memory for a request of core issued at cycle
+    int memory_flush_time(uint32_t address, int core, long long cycle);
+    // network cycles of the cache to cache transfer that answered core's last bus request: 0 on the bus
+    int cache_transfer_time(uint32_t address, int core, long long cycle);
 
     Bus(int _block_size);
 private:
-    // total traffic from read, read exclusive, write back in bytes
+    // total transfers from read, read exclusive, write back
     long long total_traffic;
     long total_invalidations_updates;
     int block_size;
+    int transfer_size;
+    // whether all connected caches have the same number of sets, so that they split addresses alike
+    bool uniform_geometry;
     std::mutex mtx;
 
     std::vector<Memory*> memory_blocks;
+    MemoryController* memory_controller;
+    MeshInterconnect* mesh;
+    // per sender, the cache that answered its last bus request on a mesh (-1 for none): the nearest copy
+    // supplies a read, the farthest one acknowledges an invalidation or update last
+    std::vector<int> responders;
+    int mem_fetch_time;
+    int mem_flush_time;
+
+    // main memory behind the bus or the home slice of a block
+    int memory_read(uint32_t block_address, long long cycle);
+    int memory_write(uint32_t block_address, long long cycle);
 };
 
 #endif //BUS_H
@@ -28,14 +28,19 @@ std::string LRUSet::get_cache_state_str(CacheState state) {
     }
 }
 
-LRUSet::LRUSet(int associativity, Protocol _protocol) : max_size(associativity), protocol(_protocol) {
+LRUSet::LRUSet(int associativity, Protocol _protocol, int _sectors, int _sector_offset_bits)
+        : max_size(associativity), protocol(_protocol), sectors(_sectors), sector_offset_bits(_sector_offset_bits) {
 }
 
-CacheState LRUSet::get_state(uint32_t tag) {
+int LRUSet::sector_of(uint32_t address) const {
+    return static_cast<int>((address >> sector_offset_bits) & static_cast<uint32_t>(sectors - 1));
+}
+
+CacheState LRUSet::get_state(uint32_t tag, uint32_t address) {
     std::lock_guard<std::mutex> lock(mtx);
     auto map_iter = map.find(tag);
     if (map_iter == map.end()) return NotPresent;
-    return map_iter->second->second;
+    return map_iter->second->states[sector_of(address)];
 }
 
 BusResponse LRUSet::unlock_and_broadcast(std::unique_lock<std::mutex>& lock, Bus* bus, BusMessage message, uint32_t address, int sender_idx, CacheState sender_cache_state) {
@@ -45,41 +50,47 @@ BusResponse LRUSet::unlock_and_broadcast(std::unique_lock<std::mutex>& lock, Bus
     return res;
 }
 
-std::tuple<bool, BusResponse> LRUSet::allocate(uint32_t tag, bool is_write, Bus* bus, uint32_t address, int sender_idx) {
+bool LRUSet::is_dirty(CacheState state) {
+    return state == Modified || state == SharedModified || state == Dirty;
+}
+
+std::pair<uint32_t, CacheState> LRUSet::insert(uint32_t tag, CacheState state) {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::pair<uint32_t, CacheState> evicted = {0, NotPresent};
+
+    if (tags.size() == static_cast<size_t>(max_size)) {
+        evicted = {tags.back().tag, tags.back().states[0]};
+        tags.pop_back();
+        map.erase(evicted.first);
+    }
+
+    Line line{tag, {}};
+    line.states.fill(NotPresent);
+    line.states[0] = state;
+    tags.push_front(line);
+    map[tag] = tags.begin();
+    return evicted;
+}
+
+BusResponse LRUSet::allocate(uint32_t tag, bool is_write, Bus* bus, uint32_t address, int sender_idx, Line& evicted) {
     std::unique_lock<std::mutex> lock(mtx);
+    const int sector = sector_of(address);
     auto it = map.find(tag);
 
-    if (it != map.end()) {
-        // tag is already in the set
-        return {false, NoResponse};
+    evicted.tag = 0;
+    evicted.states.fill(NotPresent);
+
+    if (it != map.end() && it->second->states[sector] != NotPresent) {
+        // sector is already in the set
+        return NoResponse;
     }
 
-    bool flushed = false;
-    if (tags.size() == max_size) {
-        // Evict the least recently used element from the back of the tags list
-        std::pair<uint32_t, CacheState> p = tags.back();
-        int lru_tag = p.first;
-        CacheState state = p.second;
+    if (it == map.end() && tags.size() == static_cast<size_t>(max_size)) {
+        // Evict the least recently used line from the back of the tags list; only the caller knows the set
+        // index, so it writes back the dirty sectors (MESI: Modified, Dragon: SharedModified or Dirty)
+        evicted = tags.back();
         tags.pop_back();
-        map.erase(lru_tag);
-
-        // MESI: check if LRU cache needs to be flushed
-        if (protocol == MESI) {
-            if (state == Modified) {
-                flushed = true;
-                // Write back flushed element to memory via the bus
-                bus->broadcast(WriteBack, address, sender_idx, state);
-            }
-        }
-
-        // Dragon: check if LRU cache needs to be flushed
-        if (protocol == Dragon) {
-            if (state == SharedModified || state == Dirty) {
-                flushed = true;
-                // Write back flushed element to memory via the bus
-                bus->broadcast(WriteBack, address, sender_idx, state);
-            }
-        }
+        map.erase(evicted.tag);
     }
 
     // send bus signal
@@ -125,24 +136,32 @@ std::tuple<bool, BusResponse> LRUSet::allocate(uint32_t tag, bool is_write, Bus*
         }
     }
 
-    // Insert the new element at the front
-    tags.push_front({tag, stateOfNewLine});
-    map[tag] = tags.begin();
+    // Insert the new line at the front, or move the line the sector joins there
+    if (it == map.end()) {
+        Line line{tag, {}};
+        line.states.fill(NotPresent);
+        tags.push_front(line);
+        map[tag] = tags.begin();
+    } else {
+        tags.splice(tags.begin(), tags, it->second);
+    }
+    tags.front().states[sector] = stateOfNewLine;
 
-    return {flushed, response};
+    return response;
 }
 
 std::tuple<CacheState, BusResponse, CacheState> LRUSet::write(uint32_t tag, Bus* bus, uint32_t address, int sender_idx) {
     std::unique_lock<std::mutex> lock(mtx);
     auto map_iter = map.find(tag);
 
-    if (map_iter == map.end()) {
-        // tag is not in the set
+    if (map_iter == map.end() || map_iter->second->states[sector_of(address)] == NotPresent) {
+        // sector is not in the set
         return {NotPresent, NoResponse, NotPresent};
     }
 
     auto tags_iter = map_iter->second;
-    CacheState current_state = tags_iter->second;
+    CacheState& state = tags_iter->states[sector_of(address)];
+    CacheState current_state = state;
     BusResponse response = NoResponse;
 
     // MESI: state transition due to write
@@ -151,7 +170,7 @@ std::tuple<CacheState, BusResponse, CacheState> LRUSet::write(uint32_t tag, Bus*
         if (current_state == Shared || current_state == Invalid) {
             response =  unlock_and_broadcast(lock, bus, ReadExclusive, address, sender_idx, current_state);
         }
-        tags_iter->second = Modified;
+        state = Modified;
     }
 
     // Dragon: state transition due to write
@@ -161,32 +180,33 @@ std::tuple<CacheState, BusResponse, CacheState> LRUSet::write(uint32_t tag, Bus*
             response = unlock_and_broadcast(lock, bus, BusUpdate, address, sender_idx, current_state);
             if (response == BusResponseShared || response == BusResponseDirty) {
                 // Another cache with Sc / Sm -> transition to SharedModified
-                tags_iter->second = SharedModified;
+                state = SharedModified;
             } else if (response == NoResponse) {
                 // No other copies -> transition to Dirty
-                tags_iter->second = Dirty;
+                state = Dirty;
             }
         } else if (current_state == ExclusiveDragon) {
-            tags_iter->second = Dirty;
+            state = Dirty;
         }
     }
 
     // move the looked up tag to the front of the tags list
     tags.splice(tags.begin(), tags, tags_iter);
-    return {current_state, response, tags_iter->second};
+    return {current_state, response, state};
 }
 
 std::tuple<CacheState, BusResponse, CacheState> LRUSet::read(uint32_t tag, Bus* bus, uint32_t address, int sender_idx) {
     std::unique_lock<std::mutex> lock(mtx);
     auto it = map.find(tag);
 
-    if (it == map.end()) {
-        // tag is not in the set
+    if (it == map.end() || it->second->states[sector_of(address)] == NotPresent) {
+        // sector is not in the set
         return {NotPresent, NoResponse, NotPresent};
     }
 
     auto tags_iter = it->second;
-    CacheState current_state = tags_iter->second;
+    CacheState& state = tags_iter->states[sector_of(address)];
+    CacheState current_state = state;
     BusResponse response = NoResponse;
 
     // MESI: state transition due to read
@@ -195,9 +215,9 @@ std::tuple<CacheState, BusResponse, CacheState> LRUSet::read(uint32_t tag, Bus*
         if (current_state == Invalid) {
             response = unlock_and_broadcast(lock, bus, Read, address, sender_idx, current_state);
             if (response == BusResponseShared || response == BusResponseDirty) {
-                tags_iter->second = Shared;
+                state = Shared;
             } else if (response == NoResponse) {
-                tags_iter->second = Exclusive;
+                state = Exclusive;
             }
         }
     }
@@ -209,7 +229,7 @@ std::tuple<CacheState, BusResponse, CacheState> LRUSet::read(uint32_t tag, Bus*
 
     // move the looked up tag to the front of the tags list
     tags.splice(tags.begin(), tags, it->second);
-    return {current_state, response, tags_iter->second};
+    return {current_state, response, state};
 }
 
 BusResponse LRUSet::process_signal_from_bus(uint32_t tag, BusMessage message, Bus* bus, uint32_t address, int sender_idx) {
@@ -221,20 +241,21 @@ BusResponse LRUSet::process_signal_from_bus(uint32_t tag, BusMessage message, Bu
         return NoResponse;
     }
 
-    // process bus message according to protocol
-    auto tags_iter = map_iter->second;
-    CacheState current_state = tags_iter->second;
+    // process bus message according to protocol; a sector that is not present holds no copy
+    return snoop(map_iter->second->states[sector_of(address)], message, bus, address, sender_idx);
+}
 
+BusResponse LRUSet::snoop(CacheState& current_state, BusMessage message, Bus* bus, uint32_t address, int sender_idx) {
     switch (message) {
         // MESI signals
         case Read:
             if (current_state == Modified) {
                 bus->broadcast(WriteBack, address, sender_idx, current_state);
-                tags_iter->second = Shared;
+                current_state = Shared;
                 return BusResponseDirty;
             }
             if (current_state == Exclusive) {
-                tags_iter->second = Shared;
+                current_state = Shared;
                 return BusResponseShared;
             }
             if (current_state == Shared) {
@@ -244,15 +265,15 @@ BusResponse LRUSet::process_signal_from_bus(uint32_t tag, BusMessage message, Bu
         case ReadExclusive:
             if (current_state == Modified) {
                 bus->broadcast(WriteBack, address, sender_idx, current_state);
-                tags_iter->second = Invalid;
+                current_state = Invalid;
                 return BusResponseDirty;
             }
             if (current_state == Exclusive) {
-                tags_iter->second = Invalid;
+                current_state = Invalid;
                 return BusResponseShared;
             }
             if (current_state == Shared) {
-                tags_iter->second = Invalid;
+                current_state = Invalid;
                 return BusResponseShared;
             }
             break;
@@ -260,12 +281,12 @@ BusResponse LRUSet::process_signal_from_bus(uint32_t tag, BusMessage message, Bu
         // Dragon signals
         case ReadDragon:
             if (current_state == ExclusiveDragon) {
-                tags_iter->second = SharedClean;
+                current_state = SharedClean;
                 return BusResponseShared;
             }
             if (current_state == Dirty) {
                 bus->broadcast(WriteBack, address, sender_idx, current_state);
-                tags_iter->second = SharedModified;
+                current_state = SharedModified;
                 return BusResponseDirty;
             }
             if (current_state == SharedClean) {
@@ -281,7 +302,7 @@ BusResponse LRUSet::process_signal_from_bus(uint32_t tag, BusMessage message, Bu
                 return BusResponseShared;
             }
             if (current_state == SharedModified) {
-                tags_iter->second = SharedClean;
+                current_state = SharedClean;
                 return BusResponseDirty;
             }
             break;
@@ -293,4 +314,4 @@ BusResponse LRUSet::process_signal_from_bus(uint32_t tag, BusMessage message, Bu
     }
 
     return NoResponse;
-}
\ No newline at end of file
+}
@@ -1,37 +1,58 @@
 #ifndef CACHE_H
 #define CACHE_H
 
+#include <array>
 #include <list>
 #include <mutex>
 
 #include "enums.h"
+#include "config.h"
 
 class Bus;
 
 class LRUSet {
 public:
-    // return state of block with tag
-    CacheState get_state(uint32_t tag);
+    struct Line {
+        uint32_t tag;
+        // state of each sector, NotPresent for a sector not fetched yet; a line that is not sectored only
+        // uses the first
+        std::array<CacheState, Config::MAX_SECTORS> states;
+    };
+
+    // return state of the sector holding address in the block with tag
+    CacheState get_state(uint32_t tag, uint32_t address);
     // returns {previous state, whether another copy of this line is present, current state}
     std::tuple<CacheState, BusResponse, CacheState> write(uint32_t tag, Bus* bus, uint32_t address, int sender_idx);
     // returns {previous state, whether another copy of this line is present, current_state}
     std::tuple<CacheState, BusResponse, CacheState> read(uint32_t tag, Bus* bus, uint32_t address, int sender_idx);
-    // returns true if the least recently used tag is evicted
-    std::tuple<bool, BusResponse> allocate(uint32_t tag, bool is_write, Bus* bus, uint32_t address, int sender_idx);
+    // allocate the sector holding address, evicting the least recently used line if the line is not present:
+    // the evicted line (every sector NotPresent if there was none) is handed to the caller, which writes back
+    // its dirty sectors
+    BusResponse allocate(uint32_t tag, bool is_write, Bus* bus, uint32_t address, int sender_idx, Line& evicted);
+    // insert a line that is not sectored in the given state without any bus traffic: returns the evicted {tag, state}
+    std::pair<uint32_t, CacheState> insert(uint32_t tag, CacheState state);
     // process bus signal according to protocol
     BusResponse process_signal_from_bus(uint32_t tag, BusMessage message, Bus* bus, uint32_t address, int sender_idx);
+    // apply a snooped bus message to a line in current_state according to protocol
+    static BusResponse snoop(CacheState& current_state, BusMessage message, Bus* bus, uint32_t address, int sender_idx);
+    // returns true if a line in this state must be written back on eviction
+    static bool is_dirty(CacheState state);
     // get string name of cache state for debugging
     static std::string get_cache_state_str(CacheState state);
 
-    explicit LRUSet(int associativity, Protocol _protocol);
+    // lines of sectors sectors, each 2^sector_offset_bits bytes (1 sector: lines are not sectored)
+    LRUSet(int associativity, Protocol _protocol, int _sectors, int _sector_offset_bits);
 private:
     std::mutex mtx;
     Protocol protocol;
     int max_size;
-    // list of pairs of {tag, state}
-    std::list<std::pair<uint32_t, CacheState>> tags;
-    // map from tag to iterator pointing to the pair of {tag, state} in the list of tags
-    std::unordered_map<uint32_t, std::list<std::pair<uint32_t, CacheState>>::iterator> map;
+    int sectors;
+    int sector_offset_bits;
+    // lines in LRU order
+    std::list<Line> tags;
+    // map from tag to iterator pointing to the line in the list of tags
+    std::unordered_map<uint32_t, std::list<Line>::iterator> map;
+    [[nodiscard]] int sector_of(uint32_t address) const;
     BusResponse unlock_and_broadcast(std::unique_lock<std::mutex>& lock, Bus* bus, BusMessage message, uint32_t address,
         int sender_idx, CacheState sender_cache_state);
 };
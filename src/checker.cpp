@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "checker.h"
+#include "reference_engine.h"
+#include "decoded_trace.h"
+#include "memory.h"
+#include "bus.h"
+#include "config.h"
+
+namespace {
+    const char* type_name(InstructionType type) {
+        switch (type) {
+        case LOAD: return "load";
+        case STORE: return "store";
+        case ATOMIC: return "atomic";
+        case FENCE: return "fence";
+        default: return "other";
+        }
+    }
+
+    int count_cores(const std::vector<CheckEvent>& events) {
+        int num_cores = 0;
+        for (const CheckEvent& event : events) num_cores = std::max(num_cores, event.core + 1);
+        return num_cores;
+    }
+}
+
+DifferentialChecker::DifferentialChecker(const SimConfig& _config) : config(_config) {}
+
+std::string DifferentialChecker::get_unsupported_option(const SimConfig& config) {
+    if (config.prefetcher != NoPrefetcher) return "prefetcher";
+    if (config.store_buffer > 0) return "store-buffer";
+    if (config.mshrs > 0) return "mshrs";
+    if (config.victim_cache > 0) return "victim-cache";
+    if (config.sectors > 1) return "sectors";
+    if (config.use_dram) return "dram";
+    if (config.interconnect == MeshNetwork) return "interconnect";
+    if (config.tlb) return "tlb";
+    if (!config.core_overrides.empty()) return "core<n>.<option>";
+    return "";
+}
+
+std::vector<CheckEvent> DifferentialChecker::interleave(const std::vector<Trace*>& traces) {
+    std::vector<CheckEvent> events;
+    bool is_over = false;
+    while (!is_over) {
+        is_over = true;
+        for (int j = 0; j < static_cast<int>(traces.size()); j++) {
+            if (!traces[j]->has_next_instruction()) continue;
+            is_over = false;
+            events.push_back(CheckEvent{j, traces[j]->get_current_instruction()});
+        }
+    }
+    return events;
+}
+
+bool DifferentialChecker::check(const std::vector<CheckEvent>& events, Divergence& divergence) const {
+    const int num_cores = count_cores(events);
+
+    // the optimized engine runs on instructions decoded by the same kernels as --predecode
+    Bus bus(config.block_size);
+    bus.set_memory_latencies(config.latencies.mem_fetch, config.latencies.mem_flush);
+    std::vector<std::unique_ptr<Memory>> memories;
+    std::vector<DecodedTrace> decoded(num_cores);
+    std::vector<std::vector<Instruction>> instructions(num_cores);
+    for (const CheckEvent& event : events) instructions[event.core].push_back(event.instruction);
+    for (int j = 0; j < num_cores; j++) {
+        memories.push_back(std::make_unique<Memory>(j, config.cache_size, config.associativity, config.block_size,
+                                                    Config::ADDRESS_BITS, config.protocol));
+        memories[j]->set_latencies(config.latencies);
+        bus.connect_memory(memories[j].get());
+        decoded[j].decode(Trace(std::move(instructions[j])), memories[j]->get_offset_bits(), memories[j]->get_set_index_bits());
+    }
+    ReferenceEngine reference(config, num_cores);
+
+    std::vector<long> positions(num_cores, 0);
+    for (size_t i = 0; i < events.size(); i++) {
+        const CheckEvent& event = events[i];
+        const int j = event.core;
+        const DecodedInstruction& ins = decoded[j].get_current_instruction();
+        long position = positions[j]++;
+        uint32_t address = static_cast<uint32_t>(event.instruction.value);
+
+        int cycles = 0;
+        bool is_hit = true;
+        CacheState from_state = NotPresent, to_state = NotPresent;
+        switch (ins.type) {
+        case LOAD:
+            std::tie(cycles, is_hit, from_state, to_state) = memories[j]->load(ins, &bus);
+            break;
+        case STORE:
+            std::tie(cycles, is_hit, from_state, to_state) = memories[j]->store(ins, &bus);
+            break;
+        case ATOMIC:
+            std::tie(cycles, is_hit, from_state, to_state) = memories[j]->atomic(ins, &bus);
+            break;
+        case FENCE:
+            cycles = memories[j]->memory_fence(&bus);
+            break;
+        default:
+            // compute cycles only move the clock, which nothing modeled here depends on
+            memories[j]->advance_clock(static_cast<int>(ins.tag));
+            continue;
+        }
+        ReferenceEngine::Result expected = reference.access(j, ins.type, address);
+
+        std::ostringstream differences;
+        if (cycles != expected.cycles) differences << " cycles " << cycles << " (reference " << expected.cycles << ");";
+        if (is_memory_access(ins.type)) {
+            if (is_hit != expected.is_hit) {
+                differences << " " << (is_hit ? "hit" : "miss") << " (reference " << (expected.is_hit ? "hit" : "miss") << ");";
+            }
+            if (from_state != expected.from_state || to_state != expected.to_state) {
+                differences << " " << LRUSet::get_cache_state_str(from_state) << " -> " << LRUSet::get_cache_state_str(to_state)
+                            << " (reference " << LRUSet::get_cache_state_str(expected.from_state) << " -> "
+                            << LRUSet::get_cache_state_str(expected.to_state) << ");";
+            }
+            // the effects of the bus transaction on the other copies
+            for (int k = 0; k < num_cores; k++) {
+                CacheState state = memories[k]->get_block_state(address);
+                CacheState expected_state = reference.get_state(k, address);
+                if (state != expected_state) {
+                    differences << " core " << k << " holds " << LRUSet::get_cache_state_str(state)
+                                << " (reference " << LRUSet::get_cache_state_str(expected_state) << ");";
+                }
+            }
+        }
+        if (bus.get_total_traffic() != reference.get_traffic()) {
+            differences << " bus traffic " << bus.get_total_traffic() << " bytes (reference " << reference.get_traffic() << ");";
+        }
+        if (bus.get_total_invalidations() != reference.get_invalidations_updates()) {
+            differences << " invalidations / updates " << bus.get_total_invalidations()
+                        << " (reference " << reference.get_invalidations_updates() << ");";
+        }
+
+        if (!differences.str().empty()) {
+            std::ostringstream description;
+            description << "core " << j << " instruction " << position << " (" << type_name(ins.type) << " 0x"
+                        << std::hex << address << std::dec << "):" << differences.str();
+            std::string text = description.str();
+            text.pop_back();
+            divergence = Divergence{i, text};
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<CheckEvent> DifferentialChecker::reduce(const std::vector<CheckEvent>& events, const Divergence& divergence) const {
+    std::vector<CheckEvent> reduced(events.begin(), events.begin() + static_cast<long>(divergence.event) + 1);
+
+    // sets do not interact, so the accesses to the diverging set alone should still diverge
+    int offset_bits = static_cast<int>(std::log2(config.block_size));
+    uint32_t set_mask = static_cast<uint32_t>(config.cache_size / (config.block_size * config.associativity)) - 1;
+    auto set_of = [&](const CheckEvent& event) { return (static_cast<uint32_t>(event.instruction.value) >> offset_bits) & set_mask; };
+    uint32_t diverging_set = set_of(events[divergence.event]);
+    std::vector<CheckEvent> same_set;
+    for (const CheckEvent& event : reduced) {
+        if (is_memory_access(event.instruction.type) && set_of(event) == diverging_set) same_set.push_back(event);
+    }
+    Divergence unused;
+    if (!check(same_set, unused)) reduced = std::move(same_set);
+
+    // delta debugging: drop chunks of halving size for as long as the rest still diverges
+    size_t chunks = 2;
+    for (int attempts = 0; reduced.size() >= 2 && attempts < Config::CHECK_MAX_REDUCTION_STEPS; ) {
+        size_t chunk_size = (reduced.size() + chunks - 1) / chunks;
+        bool removed = false;
+        for (size_t start = 0; start < reduced.size() && attempts < Config::CHECK_MAX_REDUCTION_STEPS; start += chunk_size) {
+            std::vector<CheckEvent> candidate(reduced.begin(), reduced.begin() + static_cast<long>(start));
+            candidate.insert(candidate.end(), reduced.begin() + static_cast<long>(std::min(start + chunk_size, reduced.size())), reduced.end());
+            attempts++;
+            if (!candidate.empty() && !check(candidate, unused)) {
+                reduced = std::move(candidate);
+                chunks = std::max<size_t>(chunks - 1, 2);
+                removed = true;
+                break;
+            }
+        }
+        if (removed) continue;
+        if (chunk_size == 1) break;
+        chunks = std::min(chunks * 2, reduced.size());
+    }
+    return reduced;
+}
+
+bool DifferentialChecker::write_reproducer(const std::vector<CheckEvent>& events, int num_cores, const std::string& prefix) {
+    // the serial executor runs one instruction of every core per round, in core order: pack the events into
+    // rounds in which the cores increase, and let idle cores that still have events ahead run a no-op
+    std::vector<std::vector<const Instruction*>> rounds;
+    int last_core = num_cores;
+    for (const CheckEvent& event : events) {
+        if (event.core <= last_core) rounds.emplace_back(num_cores, nullptr);
+        rounds.back()[event.core] = &event.instruction;
+        last_core = event.core;
+    }
+
+    for (int j = 0; j < num_cores; j++) {
+        std::string filename = prefix + "_" + std::to_string(j) + ".data";
+        std::ofstream out(filename);
+        if (!out) {
+            std::cerr << "Error: Unable to write reproducer '" << filename << "'." << std::endl;
+            return false;
+        }
+
+        size_t last_round = 0;
+        for (size_t r = 0; r < rounds.size(); r++) {
+            if (rounds[r][j] != nullptr) last_round = r + 1;
+        }
+        // a trace file needs at least one instruction
+        if (last_round == 0) out << "2 0" << std::endl;
+        for (size_t r = 0; r < last_round; r++) {
+            const Instruction* ins = rounds[r][j];
+            if (ins == nullptr) out << "2 0" << std::endl;
+            else out << static_cast<int>(ins->type) << " 0x" << std::hex << static_cast<uint32_t>(ins->value) << std::dec << std::endl;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef CHECKER_H
+#define CHECKER_H
+
+#include <string>
+#include <vector>
+
+#include "sim_config.h"
+#include "trace.h"
+
+// one instruction of one core, in the global order the cores run them
+struct CheckEvent {
+    int core;
+    Instruction instruction;
+};
+
+struct Divergence {
+    // index of the first diverging event
+    size_t event;
+    std::string description;
+};
+
+// runs the optimized engine (Memory and Bus on pre-decoded instructions) and the reference engine in lockstep,
+// comparing after every access the cycles, hit and state transition it returned, the state of the block in
+// every cache and the bus traffic and invalidation counters
+class DifferentialChecker {
+public:
+    // run both engines on events in order: returns false and describes the first divergence if they disagree
+    bool check(const std::vector<CheckEvent>& events, Divergence& divergence) const;
+    // shrink diverging events to the accesses of the diverging set, then drop every chunk of them that
+    // the divergence does not depend on
+    [[nodiscard]] std::vector<CheckEvent> reduce(const std::vector<CheckEvent>& events, const Divergence& divergence) const;
+    // write events as trace files prefix_<core>.data that the serial executor replays in the same order
+    static bool write_reproducer(const std::vector<CheckEvent>& events, int num_cores, const std::string& prefix);
+    // the first option the reference engine does not model, or an empty string if there is none
+    static std::string get_unsupported_option(const SimConfig& config);
+    // interleave the traces one instruction per core in turn, as the serial executor runs them
+    static std::vector<CheckEvent> interleave(const std::vector<Trace*>& traces);
+
+    explicit DifferentialChecker(const SimConfig& _config);
+private:
+    SimConfig config;
+};
+
+#endif //CHECKER_H
@@ -1,6 +1,8 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <cstdint>
+
 namespace Config {
      constexpr int CACHE_HIT_TIME = 1;
      constexpr int SEND_WORD_TIME = 2;
@@ -8,6 +10,83 @@ namespace Config {
      constexpr int MEM_FLUSH_TIME = 100;
      constexpr int ADDRESS_BITS = 32;
      constexpr int WORD_SIZE_BITS = 32;
+     constexpr int NUM_CORES = 4;
+     // instructions a coroutine core runs before it yields to the other cores, if it reaches no coherence point
+     constexpr int CORE_QUANTUM = 64;
+
+     // prefetchers
+     constexpr int PREFETCH_DEGREE = 2;
+     constexpr int STRIDE_TABLE_SIZE = 16;
+     constexpr int STRIDE_REGION_BITS = 12;
+     constexpr int STRIDE_CONFIDENCE_THRESHOLD = 2;
+     constexpr int STREAM_BUFFER_COUNT = 4;
+     constexpr int STREAM_BUFFER_DEPTH = 4;
+
+     // non-blocking caches: cycles of work a core can overlap with an outstanding miss
+     constexpr int MSHR_OVERLAP_WINDOW = 64;
+
+     // sectored caches: most sectors, each with its own valid and coherence state, a line can have
+     constexpr int MAX_SECTORS = 8;
+
+     // extra cycles to move a line from the victim cache back into the main cache
+     constexpr int VICTIM_HIT_TIME = 1;
+
+     // virtual memory: TLBs, and an identity mapped radix page table read through the cache on page walks
+     constexpr int TLB_L1_ENTRIES = 64;
+     constexpr int TLB_L2_ENTRIES = 1024;
+     constexpr int PAGE_SIZE = 4096;
+     constexpr int L2_TLB_HIT_TIME = 7;
+     constexpr uint32_t PAGE_TABLE_BASE = 0xC0000000;
+     constexpr int PAGE_TABLE_INDEX_BITS = 10;
+     constexpr int PAGE_TABLE_ENTRY_SIZE = 4;
+
+     // DRAM memory controller, timings in CPU cycles
+     constexpr int DRAM_CHANNELS = 2;
+     constexpr int DRAM_BANKS = 8;
+     constexpr int DRAM_ROW_SIZE = 2048;
+     constexpr int DRAM_CONTROLLER_TIME = 20;
+     constexpr int DRAM_tRCD = 30;
+     constexpr int DRAM_tCAS = 30;
+     constexpr int DRAM_tRP = 30;
+     constexpr int DRAM_tBURST = 8;
+     constexpr int DRAM_WRITE_HIGH_WATERMARK = 24;
+     constexpr int DRAM_WRITE_LOW_WATERMARK = 8;
+
+     // mesh interconnect: cycles per hop, bytes per flit and of a message without data, and a slice of the
+     // shared last-level cache on every tile
+     constexpr int MESH_HOP_TIME = 2;
+     constexpr int MESH_LINK_WIDTH = 16;
+     constexpr int MESH_CONTROL_BYTES = 8;
+     constexpr int LLC_SLICE_SIZE = 256 * 1024;
+     constexpr int LLC_ASSOCIATIVITY = 8;
+     constexpr int LLC_HIT_TIME = 10;
+
+     // trace analysis: accesses per working set window, and HyperLogLog registers (2^precision bytes)
+     constexpr long long ANALYSIS_WINDOW = 100000;
+     constexpr int ANALYSIS_HLL_PRECISION = 12;
+
+     // differential checker: reruns spent shrinking a diverging trace into a reproducer
+     constexpr int CHECK_MAX_REDUCTION_STEPS = 2000;
+
+     // embedding: batches a pushed core can have queued before push() waits for the simulation
+     constexpr int PUSH_QUEUE_BATCHES = 4;
+
+     // server mode: bytes of parsed traces kept in memory across jobs
+     constexpr long long TRACE_CACHE_SIZE = 1LL << 30;
+
+     // synthetic workloads
+     constexpr long long SYNTHETIC_LENGTH = 1000000;
+     constexpr int SYNTHETIC_FOOTPRINT = 1 << 20;
+     constexpr int SYNTHETIC_SHARED_BASE = 0x40000000;
+     constexpr int SYNTHETIC_SHARED_SIZE = 1 << 14;
+     constexpr int SYNTHETIC_STRIDE = 256;
+     constexpr int SYNTHETIC_OBJECT_SIZE = 64;
+     constexpr int SYNTHETIC_MIGRATORY_OBJECTS = 64;
+     constexpr int SYNTHETIC_STORE_PERCENT = 30;
+     constexpr int SYNTHETIC_MAX_COMPUTE = 8;
+     constexpr int SYNTHETIC_MAX_SPINS = 4;
+     constexpr int SYNTHETIC_CRITICAL_SECTION = 4;
+     constexpr double SYNTHETIC_ZIPF_THETA = 0.99;
 }
 
 #endif //CONFIG_H
@@ -1,22 +1,52 @@
+#include <optional>
 #include <thread>
+#include <stdexcept>
 
 #include "cpu.h"
 #include "memory.h"
 #include "trace.h"
+#include "decoded_trace.h"
 #include "bus.h"
 #include "profiler.h"
+#include "executor.h"
+#include "config.h"
+#include "host_perf.h"
+#include "host_numa.h"
+#include "interleaving_log.h"
 
 #define is_debug false
 
-CPU::CPU() {}
+namespace {
+    // operand handed to Memory::load / store: the raw address, or the pre-decoded instruction itself
+    uint32_t memory_operand(const Instruction& ins) { return ins.value; }
+    const DecodedInstruction& memory_operand(const DecodedInstruction& ins) { return ins; }
+
+    // fast mode access of an instruction to its cache
+    void warm(Memory* memory, const Instruction& ins, Bus* bus) { memory->warm(ins.value, ins.type, bus); }
+    void warm(Memory* memory, const DecodedInstruction& ins, Bus* bus) { memory->warm(ins, bus); }
+
+    // cycles of an OTHER instruction
+    int compute_cycles(const Instruction& ins) { return ins.value; }
+    int compute_cycles(const DecodedInstruction& ins) { return static_cast<int>(ins.tag); }
+}
+
+CPU::CPU() : bus(nullptr), host_perf(false), pin_policy(NoPinning), huge_pages(false) {}
 
 CPU::~CPU() {
     for (Memory* memory : memories) delete memory;
     for (Trace* trace : traces) delete trace;
+    for (DecodedTrace* trace : decoded_traces) delete trace;
 }
 
 void CPU::add_core(Trace *trace, Memory *memory) {
     traces.push_back(trace);
+    decoded_traces.push_back(nullptr);
+    memories.push_back(memory);
+}
+
+void CPU::add_core(DecodedTrace *trace, Memory *memory) {
+    traces.push_back(nullptr);
+    decoded_traces.push_back(trace);
     memories.push_back(memory);
 }
 
@@ -24,130 +54,395 @@ void CPU::connect_bus(Bus *_bus) {
     bus = _bus;
 }
 
-void CPU::run_core(int j, Profiler& profiler) {
-    int i = 0;
-    while (traces[j]->has_next_instruction()) {
-        const Instruction& ins = traces[j]->get_current_instruction();
-
-        int this_cycles;
-        bool is_hit;
-        CacheState from_state, to_state;
-
-        switch (ins.type) {
-            case LOAD:
-                std::tie(this_cycles, is_hit, from_state, to_state) = memories[j]->load(ins.value, bus);
-                profiler.update(LOAD, j, this_cycles, is_hit, from_state, to_state);
-                break;
-            case STORE:
-                std::tie(this_cycles, is_hit, from_state, to_state) = memories[j]->store(ins.value, bus);
-                profiler.update(STORE, j, this_cycles, is_hit, from_state, to_state);
-                break;
-            case OTHER:
-                profiler.update(STORE, j, this_cycles, is_hit, from_state, to_state);
-                break;
-            default:
-                break;
-        }
-        i++;
+void CPU::set_host_perf(bool enabled) {
+    host_perf = enabled;
+}
+
+void CPU::set_placement(PinPolicy policy, std::vector<int> cpus, bool _huge_pages) {
+    pin_policy = policy;
+    pin_cpus = std::move(cpus);
+    huge_pages = _huge_pages;
+}
+
+bool CPU::place_core(int core_id, const HostTopology& topology, std::string& error) const {
+    const int cpu = topology.choose_cpu(core_id, pin_policy, pin_cpus);
+    if (!pin_current_thread(cpu, error)) return false;
+    // the sets of the core's cache are allocated on first touch by this thread, so they land on its node
+    // already; only the trace, read in by the main thread, has to move
+    std::span<const std::byte> storage = traces[core_id] != nullptr ? traces[core_id]->get_storage()
+                                                                    : decoded_traces[core_id]->get_storage();
+    return place_on_node(storage.data(), storage.size(), topology.get_node(cpu), huge_pages, error);
+}
+
+bool CPU::start_host_perf(std::string& error) const {
+    if (!host_perf) return false;
+    HostPerfCounters probe;
+    if (!probe.is_available()) {
+        error = probe.get_error();
+        return false;
     }
+    return true;
 }
 
-void CPU::run_parallel() {
-    std::cout << "Running CPU simulation..." << std::endl;
+void CPU::count_host_thread(bool count, const std::string& thread, HostCounters& counters,
+                            const std::function<void()>& work) {
+    if (!count) {
+        work();
+        return;
+    }
+    HostPerfCounters perf;
+    perf.start();
+    work();
+    counters = perf.stop(thread);
+}
 
-    const size_t num_cores = memories.size();
-    std::vector<std::thread> threads;
-    Profiler profiler(num_cores);
+SimulationStats CPU::finish_run(const Profiler& profiler, std::chrono::steady_clock::time_point start,
+                                bool counted, std::vector<HostCounters> host_counters, const std::string& host_perf_error) {
+    auto end = std::chrono::steady_clock::now();
+    for (size_t j = 0; j < modes.size(); j++) {
+        if (!modes[j].has_undeclared_marker) continue;
+        throw std::invalid_argument("The trace of core " + std::to_string(j) + " holds a warm-up end or region of "
+                                    "interest marker it did not declare before the run.");
+    }
+    // write backs left in the DRAM write queues still reach their banks
+    if (bus->get_memory_controller() != nullptr) bus->get_memory_controller()->drain();
+    SimulationStats stats = profiler.collect(bus, memories);
+    stats.host_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    stats.host_time_ms = stats.host_time_ns / 1000000;
+    stats.has_host_perf = host_perf;
+    if (counted) stats.host_threads = std::move(host_counters);
+    stats.host_perf_error = host_perf_error;
+    return stats;
+}
 
-    auto start = std::chrono::high_resolution_clock::now();
+bool CPU::has_next_instruction(int j) const {
+    return decoded_traces[j] != nullptr ? decoded_traces[j]->has_next_instruction() : traces[j]->has_next_instruction();
+}
 
-    threads.reserve(num_cores);
-    for (size_t i = 0; i < num_cores; i++) {
-        threads.emplace_back([this, i, &profiler]() {
-            this->run_core(i, profiler);
-        });
+void CPU::reset_modes() {
+    modes.assign(memories.size(), CoreMode());
+    for (size_t j = 0; j < memories.size(); j++) {
+        TraceMarkers markers = decoded_traces[j] != nullptr ? decoded_traces[j]->get_markers() : traces[j]->get_markers();
+        modes[j].has_warmup = markers.warmup;
+        modes[j].warming = markers.warmup;
+        modes[j].has_roi = markers.roi;
+        memories[j]->set_profiling(modes[j].is_detailed());
     }
+}
 
-    for (size_t i = 0; i < num_cores; i++) {
-        threads[i].join();
+void CPU::apply_marker(int j, InstructionType type, Profiler& profiler) {
+    CoreMode& mode = modes[j];
+    bool was_detailed = mode.is_detailed();
+    switch (type) {
+        case ROI_BEGIN:
+            // the detail before the first region or the end of warm-up has already been counted
+            if (!mode.has_roi) mode.has_undeclared_marker = true;
+            else mode.in_roi = true;
+            break;
+        case ROI_END:
+            mode.in_roi = false;
+            break;
+        case WARMUP_END:
+            if (!mode.has_warmup) mode.has_undeclared_marker = true;
+            mode.warming = false;
+            break;
+        default:
+            break;
     }
 
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-    std::cout << "Simulation finished! (" << duration.count() << "ms)" << std::endl << std::endl;
+    // buffered stores and outstanding misses complete inside the region that issued them
+    if (was_detailed && !mode.is_detailed()) profiler.add_stall_cycles(j, memories[j]->fence(bus));
+    memories[j]->set_profiling(mode.is_detailed());
+}
 
-    profiler.print_stats(bus);
+bool CPU::step(int j, Profiler& profiler) {
+    if (decoded_traces[j] != nullptr) {
+        return run_instruction(j, decoded_traces[j]->get_current_instruction(), profiler);
+    } else {
+        return run_instruction(j, traces[j]->get_current_instruction(), profiler);
+    }
 }
 
+template <typename Ins>
+bool CPU::run_instruction(int j, const Ins& ins, Profiler& profiler) {
+    if (modes[j].is_detailed()) return execute(j, ins, profiler);
+    fast_forward(j, ins, profiler);
+    return false;
+}
 
-void CPU::run_serial() {
-    std::cout << "Running CPU simulation..." << std::endl;
+template <typename Ins>
+void CPU::fast_forward(int j, const Ins& ins, Profiler& profiler) {
+    switch (ins.type) {
+        case LOAD:
+        case STORE:
+        case ATOMIC:
+            warm(memories[j], ins, bus);
+            break;
+        case ROI_BEGIN:
+        case ROI_END:
+        case WARMUP_END:
+            apply_marker(j, ins.type, profiler);
+            return;
+        default:
+            break;
+    }
+    profiler.add_fast_forwarded(j);
+}
 
-    const size_t num_cores = memories.size();
+template <typename Ins>
+bool CPU::execute(int j, const Ins& ins, Profiler& profiler) {
+    int this_cycles;
+    int stall_cycles;
+    bool is_hit = true;
+    CacheState from_state, to_state;
+
+    switch (ins.type) {
+        case LOAD:
+            std::tie(this_cycles, is_hit, from_state, to_state) = memories[j]->load(memory_operand(ins), bus);
+            profiler.update(LOAD, j, this_cycles, is_hit, from_state, to_state);
+
+            if constexpr (is_debug) std::cout << "core" << j << " [load] from_state:"
+                                    << LRUSet::get_cache_state_str(from_state)
+                                    << " to_state:" << LRUSet::get_cache_state_str(to_state) << std::endl;
+            break;
+        case STORE:
+            std::tie(this_cycles, is_hit, from_state, to_state) = memories[j]->store(memory_operand(ins), bus);
+            profiler.update(STORE, j, this_cycles, is_hit, from_state, to_state);
+
+            if constexpr (is_debug) std::cout << "core" << j << " [store] from_state:"
+                                    << LRUSet::get_cache_state_str(from_state)
+                                    << " to_state:" << LRUSet::get_cache_state_str(to_state) << std::endl;
+            break;
+        case ATOMIC:
+            std::tie(this_cycles, is_hit, from_state, to_state) = memories[j]->atomic(memory_operand(ins), bus);
+            profiler.update(ATOMIC, j, this_cycles, is_hit, from_state, to_state);
+            break;
+        case FENCE:
+            this_cycles = memories[j]->memory_fence(bus);
+            profiler.update(FENCE, j, this_cycles, false, NotPresent, NotPresent);
+            // waiting for pending stores and misses to complete
+            if (this_cycles > 0) return true;
+            break;
+        case ROI_BEGIN:
+        case ROI_END:
+        case WARMUP_END:
+            apply_marker(j, ins.type, profiler);
+            return false;
+        case OTHER:
+            this_cycles = compute_cycles(ins);
+            profiler.update(OTHER, j, this_cycles, false, NotPresent, NotPresent);
+            stall_cycles = memories[j]->advance_clock(this_cycles);
+            profiler.add_stall_cycles(j, stall_cycles);
+            // waiting for an outstanding miss to complete
+            if (stall_cycles > 0) return true;
+            break;
+        default:
+            break;
+    }
+    // a miss goes out on the bus
+    return !is_hit;
+}
 
-    Profiler profiler(num_cores);
+void CPU::finish_core(int j, Profiler& profiler) {
+    if (modes[j].is_detailed()) profiler.add_stall_cycles(j, memories[j]->fence(bus));
+}
 
-    auto start = std::chrono::high_resolution_clock::now();
+void CPU::run_core(int j, Profiler& profiler) {
+    while (has_next_instruction(j)) {
+        step(j, profiler);
+    }
 
-    int i = 0;
-    bool is_over = false;
+    finish_core(j, profiler);
+}
 
-    while (!is_over) {
-        is_over = true;
-        for (int j = 0; j < memories.size(); j++) {
-            if (!traces[j]->has_next_instruction()) continue;
+void CPU::run_core_recorded(int j, Profiler& profiler, InterleavingLog& log) {
+    auto run_ordered = [this, j, &profiler, &log](const auto& ins) {
+        if (!is_ordered(ins)) {
+            run_instruction(j, ins, profiler);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(log.get_order_lock());
+        log.record(j);
+        run_instruction(j, ins, profiler);
+    };
+    while (has_next_instruction(j)) {
+        if (decoded_traces[j] != nullptr) run_ordered(decoded_traces[j]->get_current_instruction());
+        else run_ordered(traces[j]->get_current_instruction());
+    }
 
-            is_over = false;
+    // draining the store buffer writes to the cache, so it takes its turn as well
+    std::lock_guard<std::mutex> lock(log.get_order_lock());
+    log.record(j);
+    finish_core(j, profiler);
+}
 
+bool CPU::replay_step(int j, Profiler& profiler) {
+    while (has_next_instruction(j)) {
+        if (decoded_traces[j] != nullptr) {
+            const DecodedInstruction& ins = decoded_traces[j]->get_current_instruction();
+            run_instruction(j, ins, profiler);
+            if (is_ordered(ins)) return true;
+        } else {
             const Instruction& ins = traces[j]->get_current_instruction();
+            run_instruction(j, ins, profiler);
+            if (is_ordered(ins)) return true;
+        }
+    }
+    return false;
+}
+
+CoreTask CPU::run_core_coroutine(int j, Profiler& profiler) {
+    int since_suspend = 0;
+    while (has_next_instruction(j)) {
+        // let other cores catch up at coherence points, and every quantum so that cores hitting in
+        // their caches do not run ahead indefinitely
+        if (step(j, profiler) || ++since_suspend >= Config::CORE_QUANTUM) {
+            since_suspend = 0;
+            co_await std::suspend_always{};
+        }
+    }
+
+    finish_core(j, profiler);
+}
+
+SimulationStats CPU::run_coroutines(int host_threads) {
+    const size_t num_cores = memories.size();
+    reset_modes();
+    Profiler profiler(num_cores);
+    std::string host_perf_error;
+    bool count = start_host_perf(host_perf_error);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<CoreTask> tasks;
+    tasks.reserve(num_cores);
+    for (size_t i = 0; i < num_cores; i++) {
+        tasks.push_back(run_core_coroutine(i, profiler));
+    }
+
+    std::vector<HostCounters> host_counters(std::max(host_threads, 1));
+    if (host_threads <= 1) {
+        count_host_thread(count, "main", host_counters[0], [&tasks, &profiler]() {
+            ClockOrderedExecutor([&profiler](int j) { return profiler.get_core_cycles(j); }).run(tasks);
+        });
+    } else {
+        WorkStealingExecutor executor(host_threads);
+        executor.set_thread_wrapper([count, &host_counters](int w, const std::function<void()>& work) {
+            count_host_thread(count, "worker " + std::to_string(w), host_counters[w], work);
+        });
+        executor.run(tasks);
+    }
+
+    return finish_run(profiler, start, count, std::move(host_counters), host_perf_error);
+}
+
+SimulationStats CPU::run_parallel(InterleavingLog* log) {
+    const size_t num_cores = memories.size();
+    reset_modes();
+    std::vector<std::thread> threads;
+    Profiler profiler(num_cores);
+    std::string host_perf_error;
+    bool count = start_host_perf(host_perf_error);
+    std::vector<HostCounters> host_counters(num_cores);
+    std::optional<HostTopology> topology;
+    if (pin_policy != NoPinning) topology.emplace();
+    std::vector<std::string> placement_errors(num_cores);
 
-            if constexpr (is_debug) std::cout << ins.type << " " << std::hex << ins.value << std::endl;
+    auto start = std::chrono::steady_clock::now();
 
-            std::pair<int, bool> p;
+    if (log != nullptr) log->begin_recording(static_cast<int>(num_cores));
+    threads.reserve(num_cores);
+    for (size_t i = 0; i < num_cores; i++) {
+        threads.emplace_back([this, i, count, log, &profiler, &host_counters, &topology, &placement_errors]() {
+            if (pin_policy != NoPinning) place_core(static_cast<int>(i), *topology, placement_errors[i]);
+            count_host_thread(count, "core " + std::to_string(i), host_counters[i], [this, i, log, &profiler]() {
+                if (log != nullptr) this->run_core_recorded(i, profiler, *log);
+                else this->run_core(i, profiler);
+            });
+        });
+    }
 
-            int this_cycles;
-            bool is_hit;
-            CacheState from_state, to_state;
+    for (size_t i = 0; i < num_cores; i++) {
+        threads[i].join();
+    }
+    if (log != nullptr) log->end_recording();
+    for (size_t i = 0; i < num_cores; i++) {
+        if (placement_errors[i].empty()) continue;
+        std::cerr << "Warning: Unable to place core " << i << " on its host CPU: " << placement_errors[i] << std::endl;
+        break;
+    }
 
-            int prev_traffic = bus->get_total_traffic();
-            int prev_invalidations = bus->get_total_invalidations();
+    return finish_run(profiler, start, count, std::move(host_counters), host_perf_error);
+}
 
-            switch (ins.type) {
-                case LOAD:
-                std::tie(this_cycles, is_hit, from_state, to_state) = memories[j]->load(ins.value, bus);
+SimulationStats CPU::run_serial() {
+    const size_t num_cores = memories.size();
+    reset_modes();
 
-                profiler.update(LOAD, j, this_cycles, is_hit, from_state, to_state);
+    Profiler profiler(num_cores);
+    std::string host_perf_error;
+    bool count = start_host_perf(host_perf_error);
+    std::vector<HostCounters> host_counters(1);
 
-                if constexpr (is_debug) std::cout << "core" << j <<  " " << i << " [load] from_state:"
-                                        << LRUSet::get_cache_state_str(from_state)
-                                        << " to_state:" << LRUSet::get_cache_state_str(to_state) << std::endl;
-                break;
-            case STORE:
-                std::tie(this_cycles, is_hit, from_state, to_state) = memories[j]->store(ins.value, bus);
+    auto start = std::chrono::steady_clock::now();
 
-                profiler.update(STORE, j, this_cycles, is_hit, from_state, to_state);
+    count_host_thread(count, "main", host_counters[0], [this, &profiler]() {
+        bool is_over = false;
 
-                if constexpr (is_debug) std::cout << "core" << j <<  " " << i << " [store] from_state:"
-                                        << LRUSet::get_cache_state_str(from_state)
-                                        << " to_state:" << LRUSet::get_cache_state_str(to_state) << std::endl;
-                break;
-            case OTHER:
-                profiler.update(STORE, j, this_cycles, is_hit, from_state, to_state);
-                break;
-            default:
-                break;
+        while (!is_over) {
+            is_over = true;
+            for (int j = 0; j < static_cast<int>(memories.size()); j++) {
+                if (!has_next_instruction(j)) continue;
+
+                is_over = false;
+                step(j, profiler);
             }
+        }
 
-            if constexpr (is_debug) std::cout << "cycles: " << std::dec << this_cycles
-                                    << " traffic: " << bus->get_total_traffic() - prev_traffic
-                                    << " invalidations/updates: " << bus->get_total_invalidations() << std::endl;
+        for (int j = 0; j < static_cast<int>(memories.size()); j++) {
+            finish_core(j, profiler);
         }
-        i++;
-    }
+    });
 
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-    std::cout << "Simulation finished! (" << duration.count() << "ms)" << std::endl << std::endl;
+    return finish_run(profiler, start, count, std::move(host_counters), host_perf_error);
+}
+
+SimulationStats CPU::run_replay(const InterleavingLog& log) {
+    const size_t num_cores = memories.size();
+    reset_modes();
+    Profiler profiler(num_cores);
+    std::string host_perf_error;
+    bool count = start_host_perf(host_perf_error);
+    std::vector<HostCounters> host_counters(1);
+
+    auto start = std::chrono::steady_clock::now();
+
+    count_host_thread(count, "main", host_counters[0], [this, &log, &profiler]() {
+        // a core whose trace has ended takes its last recorded step to drain its store buffer
+        std::vector<uint8_t> finished(memories.size(), 0);
+        bool matches = log.get_num_cores() == static_cast<int>(memories.size());
+        for (const InterleavingLog::Run& run : log.get_runs()) {
+            if (!matches) break;
+            for (uint64_t k = 0; k < run.steps; k++) {
+                if (replay_step(run.core, profiler)) continue;
+                if (finished[run.core]) {
+                    matches = false;
+                    break;
+                }
+                finish_core(run.core, profiler);
+                finished[run.core] = 1;
+            }
+        }
+
+        // whatever the log does not cover runs in core order
+        for (int j = 0; j < static_cast<int>(memories.size()); j++) {
+            if (finished[j]) continue;
+            matches = false;
+            while (has_next_instruction(j)) step(j, profiler);
+            finish_core(j, profiler);
+        }
+        if (!matches) std::cerr << "Warning: The interleaving log does not match the traces; the replay diverges from the recorded run." << std::endl;
+    });
 
-    profiler.print_stats(bus);
+    return finish_run(profiler, start, count, std::move(host_counters), host_perf_error);
 }
@@ -1,27 +1,106 @@
 #ifndef CPU_H
 #define CPU_H
 
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <vector>
+
+#include "stats.h"
+#include "executor.h"
+#include "trace.h"
 
 class Profiler;
 class Memory;
 class Bus;
-class Trace;
+class DecodedTrace;
+class InterleavingLog;
+class HostTopology;
 
 class CPU {
 public:
     void connect_bus(Bus* bus);
-    void run_serial();
-    void run_parallel();
+    // run every core to the end of its trace: returns the stats of the run
+    SimulationStats run_serial();
+    // record the global order of the ordered steps of the threads into log if it is set
+    SimulationStats run_parallel(InterleavingLog* log = nullptr);
+    // run every core on the calling thread in the order recorded by a threaded run of the same traces
+    SimulationStats run_replay(const InterleavingLog& log);
+    // run every core as a coroutine: on the calling thread in clock order if host_threads <= 1,
+    // otherwise on host_threads work-stealing threads
+    SimulationStats run_coroutines(int host_threads);
     void add_core(Trace* trace, Memory* memory);
+    void add_core(DecodedTrace* trace, Memory* memory);
+    // count host hardware events of every host thread of the next runs
+    void set_host_perf(bool enabled);
+    // pin the threads of the next threaded runs to host CPUs chosen by policy (cpus for PinList) and move
+    // the trace of each core to the NUMA node of its thread, on transparent huge pages if huge_pages is set
+    void set_placement(PinPolicy policy, std::vector<int> cpus, bool huge_pages);
 
     CPU();
     ~CPU();
 private:
+    // how a core runs its trace: in the fast mode until its warm-up ends, then in detail, but only inside
+    // its regions of interest if its trace marks any
+    struct CoreMode {
+        bool has_warmup = false;
+        bool warming = false;
+        bool has_roi = false;
+        bool in_roi = false;
+        // a marker the trace did not report before the run, which came too late to be applied
+        bool has_undeclared_marker = false;
+        [[nodiscard]] bool is_detailed() const { return !warming && (!has_roi || in_roi); }
+    };
+
+    // set every core to the mode the markers of its trace start it in
+    void reset_modes();
+    // apply a marker instruction to the mode of a core
+    void apply_marker(int core_id, InstructionType type, Profiler& profiler);
     void run_core(int code_id, Profiler& profiler);
+    // run_core, taking every step that touches the memory system in turn with the other threads
+    void run_core_recorded(int core_id, Profiler& profiler, InterleavingLog& log);
+    // run a core up to and including its next ordered step: returns false if its trace has ended
+    bool replay_step(int core_id, Profiler& profiler);
+    // the core finishes once its buffered stores are written
+    void finish_core(int core_id, Profiler& profiler);
+    bool has_next_instruction(int core_id) const;
+    CoreTask run_core_coroutine(int core_id, Profiler& profiler);
+    // execute the next instruction of a core: returns true if it reached a coherence point
+    // (a miss sent on the bus, or a stall on an outstanding miss)
+    bool step(int core_id, Profiler& profiler);
+    // run an instruction in the mode of its core: returns what execute returns, false in the fast mode
+    template <typename Ins>
+    bool run_instruction(int core_id, const Ins& ins, Profiler& profiler);
+    // whether an instruction must keep its place among the steps of the other cores: compute instructions
+    // only touch their own core
+    template <typename Ins>
+    static bool is_ordered(const Ins& ins) { return ins.type != OTHER; }
+    template <typename Ins>
+    bool execute(int core_id, const Ins& ins, Profiler& profiler);
+    // run an instruction in the fast mode: accesses only update cache state, nothing is timed or profiled
+    template <typename Ins>
+    void fast_forward(int core_id, const Ins& ins, Profiler& profiler);
+    // pin the calling thread for a core and move the core's trace to its node: false, with the reason in
+    // error, if the host refuses
+    bool place_core(int core_id, const HostTopology& topology, std::string& error) const;
+    // whether this run counts host events: false, with the reason in error, if the host cannot
+    bool start_host_perf(std::string& error) const;
+    // run work, counting the host events of the calling thread into counters if count is set
+    static void count_host_thread(bool count, const std::string& thread, HostCounters& counters,
+                                  const std::function<void()>& work);
+    // collect the stats of a run; throws std::invalid_argument if a core reached a marker its trace did not declare
+    SimulationStats finish_run(const Profiler& profiler, std::chrono::steady_clock::time_point start,
+                               bool counted, std::vector<HostCounters> host_counters, const std::string& host_perf_error);
+    // each core runs either a raw trace or a pre-decoded one; the other entry is nullptr
     std::vector<Trace*> traces;
+    std::vector<DecodedTrace*> decoded_traces;
     std::vector<Memory*> memories;
+    std::vector<CoreMode> modes;
     Bus* bus;
+    bool host_perf;
+    PinPolicy pin_policy;
+    std::vector<int> pin_cpus;
+    bool huge_pages;
 };
 
 #endif
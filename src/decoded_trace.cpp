@@ -0,0 +1,190 @@
+#include <array>
+#include <filesystem>
+#include <utility>
+
+#include "decoded_trace.h"
+
+namespace {
+    constexpr uint32_t CACHE_MAGIC = 0x44534343; // "CCSD"
+    constexpr uint32_t CACHE_VERSION = 1;
+    // addresses are decoded in chunks that stay in L1 of the host
+    constexpr size_t DECODE_CHUNK = 1024;
+
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        int32_t offset_bits;
+        int32_t set_index_bits;
+        uint64_t trace_hash;
+        uint64_t count;
+    };
+
+    // split addresses into set index and tag: a plain loop over unaliased arrays that the compiler
+    // vectorizes (shifts and masks only, no branches)
+    void decode_addresses(const uint32_t* __restrict addresses, size_t count, int offset_bits, int set_index_bits,
+                          uint32_t* __restrict set_indices, uint32_t* __restrict tags) {
+        uint32_t set_mask = (1u << set_index_bits) - 1;
+        int tag_shift = offset_bits + set_index_bits;
+        for (size_t i = 0; i < count; i++) {
+            set_indices[i] = (addresses[i] >> offset_bits) & set_mask;
+            tags[i] = addresses[i] >> tag_shift;
+        }
+    }
+
+    // the same kernel with the geometry known at compile time, so shifts and masks become immediates
+    template<int OffsetBits, int SetIndexBits>
+    void decode_addresses_fixed(const uint32_t* __restrict addresses, size_t count, int, int,
+                                uint32_t* __restrict set_indices, uint32_t* __restrict tags) {
+        constexpr uint32_t set_mask = (1u << SetIndexBits) - 1;
+        for (size_t i = 0; i < count; i++) {
+            set_indices[i] = (addresses[i] >> OffsetBits) & set_mask;
+            tags[i] = addresses[i] >> (OffsetBits + SetIndexBits);
+        }
+    }
+
+    using DecodeKernel = void (*)(const uint32_t*, size_t, int, int, uint32_t*, uint32_t*);
+
+    // common geometries get a specialized kernel: 16 to 64 byte blocks and 16 to 4096 sets
+    constexpr int MIN_OFFSET_BITS = 4;
+    constexpr int MAX_OFFSET_BITS = 6;
+    constexpr int MIN_SET_INDEX_BITS = 4;
+    constexpr int MAX_SET_INDEX_BITS = 12;
+    constexpr int NUM_SET_INDEX_BITS = MAX_SET_INDEX_BITS - MIN_SET_INDEX_BITS + 1;
+
+    template<int OffsetBits, int... SetIndexBits>
+    constexpr std::array<DecodeKernel, sizeof...(SetIndexBits)> kernels_for(std::integer_sequence<int, SetIndexBits...>) {
+        return {&decode_addresses_fixed<OffsetBits, MIN_SET_INDEX_BITS + SetIndexBits>...};
+    }
+
+    constexpr std::array<std::array<DecodeKernel, NUM_SET_INDEX_BITS>, MAX_OFFSET_BITS - MIN_OFFSET_BITS + 1> FIXED_KERNELS = {
+        kernels_for<4>(std::make_integer_sequence<int, NUM_SET_INDEX_BITS>{}),
+        kernels_for<5>(std::make_integer_sequence<int, NUM_SET_INDEX_BITS>{}),
+        kernels_for<6>(std::make_integer_sequence<int, NUM_SET_INDEX_BITS>{}),
+    };
+
+    DecodeKernel select_kernel(int offset_bits, int set_index_bits) {
+        if (offset_bits < MIN_OFFSET_BITS || offset_bits > MAX_OFFSET_BITS
+            || set_index_bits < MIN_SET_INDEX_BITS || set_index_bits > MAX_SET_INDEX_BITS) {
+            return &decode_addresses;
+        }
+        return FIXED_KERNELS[offset_bits - MIN_OFFSET_BITS][set_index_bits - MIN_SET_INDEX_BITS];
+    }
+}
+
+DecodedTrace::DecodedTrace() : current_instruction(0) {}
+
+void DecodedTrace::decode(const Trace& trace, int offset_bits, int set_index_bits) {
+    const std::vector<Instruction>& instructions = trace.get_instructions();
+    data.resize(instructions.size());
+    current_instruction = 0;
+
+    DecodeKernel kernel = select_kernel(offset_bits, set_index_bits);
+
+    uint32_t addresses[DECODE_CHUNK];
+    uint32_t set_indices[DECODE_CHUNK];
+    uint32_t tags[DECODE_CHUNK];
+
+    for (size_t base = 0; base < instructions.size(); base += DECODE_CHUNK) {
+        size_t count = std::min(DECODE_CHUNK, instructions.size() - base);
+        for (size_t i = 0; i < count; i++) addresses[i] = static_cast<uint32_t>(instructions[base + i].value);
+
+        kernel(addresses, count, offset_bits, set_index_bits, set_indices, tags);
+
+        for (size_t i = 0; i < count; i++) {
+            const Instruction& ins = instructions[base + i];
+            if (!is_memory_access(ins.type)) {
+                // OTHER carries a cycle count, fences and markers nothing, not an address
+                data[base + i] = DecodedInstruction{static_cast<uint32_t>(ins.value), 0, ins.type};
+            } else {
+                data[base + i] = DecodedInstruction{tags[i], set_indices[i], ins.type};
+            }
+        }
+    }
+}
+
+bool DecodedTrace::load_cache(const std::string& path, uint64_t trace_hash, int offset_bits, int set_index_bits) {
+    std::ifstream infile(path, std::ios::binary);
+    if (!infile) return false;
+
+    CacheHeader header{};
+    infile.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!infile || header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.trace_hash != trace_hash
+        || header.offset_bits != offset_bits || header.set_index_bits != set_index_bits) {
+        std::cerr << "Warning: Ignoring stale decoded trace '" << path << "'." << std::endl;
+        return false;
+    }
+
+    data.resize(header.count);
+    infile.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(header.count * sizeof(DecodedInstruction)));
+    if (!infile) {
+        std::cerr << "Warning: Truncated decoded trace '" << path << "'." << std::endl;
+        data.clear();
+        return false;
+    }
+
+    current_instruction = 0;
+    std::cout << "Loaded " << data.size() << " decoded instructions from '" << path << "'." << std::endl;
+    return true;
+}
+
+bool DecodedTrace::save_cache(const std::string& path, uint64_t trace_hash, int offset_bits, int set_index_bits) const {
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+    std::ofstream outfile(path, std::ios::binary | std::ios::trunc);
+    if (!outfile) {
+        std::cerr << "Warning: Unable to write decoded trace '" << path << "'." << std::endl;
+        return false;
+    }
+
+    CacheHeader header{CACHE_MAGIC, CACHE_VERSION, offset_bits, set_index_bits, trace_hash, data.size()};
+    outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    outfile.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size() * sizeof(DecodedInstruction)));
+    return static_cast<bool>(outfile);
+}
+
+std::string DecodedTrace::get_cache_path(const std::string& cache_dir, const std::string& trace_filename,
+                                         uint64_t trace_hash, int offset_bits, int set_index_bits) {
+    std::ostringstream name;
+    name << std::filesystem::path(trace_filename).filename().string() << "." << std::hex << trace_hash << std::dec
+         << "." << offset_bits << "-" << set_index_bits << ".decoded";
+    return (std::filesystem::path(cache_dir) / name.str()).string();
+}
+
+bool DecodedTrace::hash_file(const std::string& filename, uint64_t& hash) {
+    std::ifstream infile(filename, std::ios::binary);
+    if (!infile) {
+        std::cerr << "Error: Unable to open file '" << filename << "'." << std::endl;
+        return false;
+    }
+
+    hash = 14695981039346656037ull;
+    char buffer[1 << 16];
+    while (infile.read(buffer, sizeof(buffer)) || infile.gcount() > 0) {
+        for (std::streamsize i = 0; i < infile.gcount(); i++) {
+            hash ^= static_cast<unsigned char>(buffer[i]);
+            hash *= 1099511628211ull;
+        }
+    }
+    return true;
+}
+
+const DecodedInstruction& DecodedTrace::get_current_instruction() {
+    if (current_instruction < data.size()) {
+        return data[current_instruction++];
+    } else {
+        throw std::out_of_range("No further instructions available.");
+    }
+}
+
+bool DecodedTrace::has_next_instruction() const {
+    return current_instruction < data.size();
+}
+
+TraceMarkers DecodedTrace::get_markers() const {
+    return find_markers(data.data(), data.size());
+}
+
+std::span<const std::byte> DecodedTrace::get_storage() const {
+    return std::as_bytes(std::span<const DecodedInstruction>(data));
+}
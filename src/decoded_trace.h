@@ -0,0 +1,46 @@
+#ifndef DECODED_TRACE_H
+#define DECODED_TRACE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+
+// an instruction with its address already split for one cache geometry
+struct DecodedInstruction {
+    // tag of the accessed block, the number of cycles of an OTHER instruction, or the unused value of a
+    // fence or marker
+    uint32_t tag;
+    uint32_t set_index;
+    InstructionType type;
+};
+
+// a trace decoded once for a cache geometry, so that the simulation loop and the bus skip the address
+// decomposition; decoded traces can be cached on disk, keyed by trace file hash and geometry
+class DecodedTrace {
+public:
+    DecodedTrace();
+    // decode every instruction of the trace for a cache with the given geometry
+    void decode(const Trace& trace, int offset_bits, int set_index_bits);
+    // load a decoded trace cached on disk: returns false if there is none for this trace hash and geometry
+    bool load_cache(const std::string& path, uint64_t trace_hash, int offset_bits, int set_index_bits);
+    bool save_cache(const std::string& path, uint64_t trace_hash, int offset_bits, int set_index_bits) const;
+    // path of the cached decoded trace for a trace file in cache_dir
+    static std::string get_cache_path(const std::string& cache_dir, const std::string& trace_filename,
+        uint64_t trace_hash, int offset_bits, int set_index_bits);
+    // FNV-1a hash of the contents of a trace file
+    static bool hash_file(const std::string& filename, uint64_t& hash);
+
+    const DecodedInstruction& get_current_instruction();
+    bool has_next_instruction() const;
+    [[nodiscard]] TraceMarkers get_markers() const;
+    // memory holding the decoded instructions
+    [[nodiscard]] std::span<const std::byte> get_storage() const;
+
+private:
+    std::vector<DecodedInstruction> data;
+    size_t current_instruction;
+};
+
+#endif // DECODED_TRACE_H
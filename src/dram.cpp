@@ -0,0 +1,154 @@
+#include <algorithm>
+
+#include "dram.h"
+#include "config.h"
+
+MemoryController::MemoryController(int _num_channels, int _num_banks, PagePolicy _policy) :
+        num_channels(_num_channels), num_banks(_num_banks), policy(_policy) {
+    channels.resize(num_channels);
+    for (Channel& channel : channels) {
+        channel.bus_ready = 0;
+        channel.is_draining_writes = false;
+        channel.banks = std::vector<Bank>(num_banks, Bank{false, 0, 0, BankStats{}});
+    }
+}
+
+std::tuple<int, int, uint32_t> MemoryController::decode(uint32_t block_address) const {
+    uint32_t row_index = block_address / Config::DRAM_ROW_SIZE;
+    int channel = static_cast<int>(row_index % num_channels);
+    row_index /= num_channels;
+    int bank = static_cast<int>(row_index % num_banks);
+    uint32_t row = row_index / num_banks;
+    return {channel, bank, row};
+}
+
+std::deque<MemoryController::Request>::iterator MemoryController::pick(Channel& channel, std::deque<Request>& queue) {
+    // first ready: the oldest request to an open row
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        const Bank& bank = channel.banks[it->bank];
+        if (bank.is_row_open && bank.open_row == it->row) return it;
+    }
+    // first come first served
+    return queue.begin();
+}
+
+long long MemoryController::service(Channel& channel, const Request& request, long long cycle) {
+    Bank& bank = channel.banks[request.bank];
+    long long arrival = std::max(request.arrival, cycle);
+
+    // cores run on loosely synchronised clocks: a bank busy more than a row cycle past this request's
+    // clock was busy with another core's future, so it only delays requests close to it in time
+    constexpr int row_cycle = Config::DRAM_tRP + Config::DRAM_tRCD + Config::DRAM_tCAS;
+    long long start = bank.ready - arrival > row_cycle ? arrival : std::max(arrival, bank.ready);
+
+    int access_time;
+    if (bank.is_row_open && bank.open_row == request.row) {
+        access_time = Config::DRAM_tCAS;
+        bank.stats.row_hits++;
+    } else if (bank.is_row_open) {
+        // precharge the open row, then activate the requested one
+        access_time = Config::DRAM_tRP + Config::DRAM_tRCD + Config::DRAM_tCAS;
+        bank.stats.row_conflicts++;
+    } else {
+        access_time = Config::DRAM_tRCD + Config::DRAM_tCAS;
+        bank.stats.row_empty++;
+    }
+
+    long long data_ready = start + access_time;
+    long long transfer_start = channel.bus_ready - data_ready > Config::DRAM_tBURST ? data_ready
+                                                                                    : std::max(data_ready, channel.bus_ready);
+    long long done = transfer_start + Config::DRAM_tBURST;
+    channel.bus_ready = std::max(channel.bus_ready, done);
+
+    if (policy == OpenPage) {
+        // leave the row open for later hits
+        bank.is_row_open = true;
+        bank.open_row = request.row;
+        bank.ready = std::max(bank.ready, data_ready);
+    } else {
+        // precharge right after the access
+        bank.is_row_open = false;
+        bank.ready = std::max(bank.ready, done + Config::DRAM_tRP);
+    }
+
+    if (request.is_write) {
+        bank.stats.writes++;
+    } else {
+        bank.stats.reads++;
+    }
+    return done;
+}
+
+void MemoryController::drain_writes(Channel& channel, long long cycle) {
+    if (channel.write_queue.size() >= Config::DRAM_WRITE_HIGH_WATERMARK) channel.is_draining_writes = true;
+    if (!channel.is_draining_writes) return;
+
+    while (channel.write_queue.size() > Config::DRAM_WRITE_LOW_WATERMARK) {
+        auto it = pick(channel, channel.write_queue);
+        Request request = *it;
+        channel.write_queue.erase(it);
+        service(channel, request, cycle);
+    }
+    channel.is_draining_writes = false;
+}
+
+int MemoryController::read(uint32_t block_address, long long cycle) {
+    std::lock_guard<std::mutex> lock(mtx);
+    int channel_idx, bank;
+    uint32_t row;
+    std::tie(channel_idx, bank, row) = decode(block_address);
+    Channel& channel = channels[channel_idx];
+
+    // the latest data of a block waiting in the write queue is forwarded from there
+    for (const Request& pending : channel.write_queue) {
+        if (pending.block_address == block_address) return Config::DRAM_CONTROLLER_TIME;
+    }
+
+    drain_writes(channel, cycle);
+
+    long long done = service(channel, Request{block_address, bank, row, cycle, false}, cycle);
+    return static_cast<int>(done - cycle) + Config::DRAM_CONTROLLER_TIME;
+}
+
+int MemoryController::write(uint32_t block_address, long long cycle) {
+    std::lock_guard<std::mutex> lock(mtx);
+    int channel_idx, bank;
+    uint32_t row;
+    std::tie(channel_idx, bank, row) = decode(block_address);
+    Channel& channel = channels[channel_idx];
+
+    // write backs are posted: the writer only waits for the controller to accept the block
+    channel.write_queue.push_back(Request{block_address, bank, row, cycle, true});
+    drain_writes(channel, cycle);
+    return Config::DRAM_CONTROLLER_TIME;
+}
+
+void MemoryController::drain() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (Channel& channel : channels) {
+        while (!channel.write_queue.empty()) {
+            auto it = pick(channel, channel.write_queue);
+            Request request = *it;
+            channel.write_queue.erase(it);
+            // each write starts no earlier than it was posted
+            service(channel, request, 0);
+        }
+        channel.is_draining_writes = false;
+    }
+}
+
+int MemoryController::get_num_channels() const {
+    return num_channels;
+}
+
+int MemoryController::get_num_banks() const {
+    return num_banks;
+}
+
+PagePolicy MemoryController::get_page_policy() const {
+    return policy;
+}
+
+const BankStats& MemoryController::get_bank_stats(int channel, int bank) const {
+    return channels[channel].banks[bank].stats;
+}
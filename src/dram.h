@@ -0,0 +1,81 @@
+#ifndef DRAM_H
+#define DRAM_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "enums.h"
+
+struct BankStats {
+    long reads = 0;
+    long writes = 0;
+    // accesses to the open row
+    long row_hits = 0;
+    // accesses to a precharged bank
+    long row_empty = 0;
+    // accesses that had to close another row first
+    long row_conflicts = 0;
+};
+
+// DRAM memory controller behind the bus: channels of banks with row buffers. A read blocks its core, so it is
+// serviced as it arrives; write backs are posted to a per-channel write queue that is drained in batches,
+// scheduled first-ready first-come-first-served (row hits first, then oldest)
+class MemoryController {
+public:
+    // read a block: returns the cycles until it is delivered
+    int read(uint32_t block_address, long long cycle);
+    // post a write back of a block: returns the cycles the writer waits to hand it over
+    int write(uint32_t block_address, long long cycle);
+    // write every write back still queued to its bank, at the end of a run
+    void drain();
+
+    [[nodiscard]] int get_num_channels() const;
+    [[nodiscard]] int get_num_banks() const;
+    [[nodiscard]] PagePolicy get_page_policy() const;
+    [[nodiscard]] const BankStats& get_bank_stats(int channel, int bank) const;
+
+    MemoryController(int _num_channels, int _num_banks, PagePolicy _policy);
+private:
+    struct Request {
+        uint32_t block_address;
+        int bank;
+        uint32_t row;
+        long long arrival;
+        bool is_write;
+    };
+
+    struct Bank {
+        bool is_row_open;
+        uint32_t open_row;
+        // cycle at which the bank can start its next access
+        long long ready;
+        BankStats stats;
+    };
+
+    struct Channel {
+        // cycle at which the data bus of the channel is free
+        long long bus_ready;
+        bool is_draining_writes;
+        std::vector<Bank> banks;
+        std::deque<Request> write_queue;
+    };
+
+    std::mutex mtx;
+    int num_channels;
+    int num_banks;
+    PagePolicy policy;
+    std::vector<Channel> channels;
+
+    // map a block address to {channel, bank, row}: column bits lowest, so a row holds consecutive blocks
+    [[nodiscard]] std::tuple<int, int, uint32_t> decode(uint32_t block_address) const;
+    // pick the next write of the queue: the oldest row hit, else the oldest write
+    std::deque<Request>::iterator pick(Channel& channel, std::deque<Request>& queue);
+    // issue a request to its bank: returns the cycle its data transfer completes
+    long long service(Channel& channel, const Request& request, long long cycle);
+    // drain writes once the write queue passes the high watermark, down to the low watermark
+    void drain_writes(Channel& channel, long long cycle);
+};
+
+#endif //DRAM_H
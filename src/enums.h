@@ -48,4 +48,53 @@ enum Protocol {
     Dragon,
 };
 
+enum PagePolicy {
+    OpenPage,
+    ClosedPage,
+};
+
+enum PrefetcherType {
+    NoPrefetcher,
+    NextLine,
+    Stride,
+    StreamBuffer,
+};
+
+enum ExecutorType {
+    // one OS thread per simulated core
+    ThreadPerCore,
+    // round-robin over the cores on the calling thread
+    RoundRobin,
+    // cores as coroutines multiplexed on a few host threads
+    Coroutines,
+};
+
+enum InterconnectType {
+    // one snooping bus, main memory behind it
+    SharedBus,
+    // 2D mesh of tiles with a slice of a shared last-level cache on each
+    MeshNetwork,
+};
+
+// host CPUs the threads of the thread-per-core executor are pinned to
+enum PinPolicy {
+    NoPinning,
+    // fill the CPUs of one NUMA node before the next
+    PinCompact,
+    // deal the threads out over the NUMA nodes in turn
+    PinSpread,
+    // CPUs named by the user
+    PinList,
+};
+
+enum SyntheticPattern {
+    Sequential,
+    Strided,
+    Uniform,
+    Zipfian,
+    ProducerConsumer,
+    Migratory,
+    LockContention,
+};
+
 #endif //ENUMS_H
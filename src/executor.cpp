@@ -0,0 +1,117 @@
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "executor.h"
+
+CoreTask::CoreTask(std::coroutine_handle<promise_type> _handle) : handle(_handle) {}
+
+CoreTask::CoreTask(CoreTask&& other) noexcept : handle(other.handle) {
+    other.handle = nullptr;
+}
+
+CoreTask::~CoreTask() {
+    if (handle) handle.destroy();
+}
+
+bool CoreTask::resume() {
+    if (!handle || handle.done()) return false;
+    handle.resume();
+    if (handle.promise().exception) std::rethrow_exception(handle.promise().exception);
+    return !handle.done();
+}
+
+ClockOrderedExecutor::ClockOrderedExecutor(std::function<long long(int)> _clock_of) : clock_of(std::move(_clock_of)) {}
+
+void ClockOrderedExecutor::run(std::vector<CoreTask>& tasks) {
+    // min-heap of {clock, core}
+    using Entry = std::pair<long long, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> ready;
+    for (int i = 0; i < static_cast<int>(tasks.size()); i++) ready.emplace(clock_of(i), i);
+
+    while (!ready.empty()) {
+        int i = ready.top().second;
+        ready.pop();
+        if (tasks[i].resume()) ready.emplace(clock_of(i), i);
+    }
+}
+
+WorkStealingExecutor::WorkStealingExecutor(int _num_threads) : num_threads(_num_threads) {}
+
+void WorkStealingExecutor::set_thread_wrapper(std::function<void(int, const std::function<void()>&)> _thread_wrapper) {
+    thread_wrapper = std::move(_thread_wrapper);
+}
+
+void WorkStealingExecutor::run(std::vector<CoreTask>& tasks) {
+    struct Queue {
+        std::mutex mtx;
+        std::deque<int> cores;
+    };
+
+    const int num_queues = std::max(1, num_threads);
+    std::vector<std::unique_ptr<Queue>> queues;
+    for (int w = 0; w < num_queues; w++) queues.push_back(std::make_unique<Queue>());
+    for (int i = 0; i < static_cast<int>(tasks.size()); i++) queues[i % num_queues]->cores.push_back(i);
+
+    // a core is in at most one queue or being resumed by one thread, so it never runs on two threads at once
+    std::atomic<int> remaining(static_cast<int>(tasks.size()));
+    std::exception_ptr error;
+    std::mutex error_mtx;
+
+    auto worker = [&](int w) {
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            int core = -1;
+            {
+                std::lock_guard<std::mutex> lock(queues[w]->mtx);
+                if (!queues[w]->cores.empty()) {
+                    core = queues[w]->cores.front();
+                    queues[w]->cores.pop_front();
+                }
+            }
+            // steal from the back of another queue, away from where its owner works
+            for (int k = 1; core < 0 && k < num_queues; k++) {
+                Queue& victim = *queues[(w + k) % num_queues];
+                std::lock_guard<std::mutex> lock(victim.mtx);
+                if (!victim.cores.empty()) {
+                    core = victim.cores.back();
+                    victim.cores.pop_back();
+                }
+            }
+            if (core < 0) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            bool alive;
+            try {
+                alive = tasks[core].resume();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mtx);
+                if (!error) error = std::current_exception();
+                alive = false;
+            }
+            if (alive) {
+                std::lock_guard<std::mutex> lock(queues[w]->mtx);
+                queues[w]->cores.push_back(core);
+            } else {
+                remaining.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_queues);
+    for (int w = 0; w < num_queues; w++) {
+        if (thread_wrapper) {
+            threads.emplace_back([&, w]() { thread_wrapper(w, [&worker, w]() { worker(w); }); });
+        } else {
+            threads.emplace_back(worker, w);
+        }
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    if (error) std::rethrow_exception(error);
+}
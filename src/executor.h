@@ -0,0 +1,61 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <vector>
+
+// a simulated core as a coroutine: it runs its trace and suspends at coherence points,
+// so that an executor can interleave many cores on few host threads
+class CoreTask {
+public:
+    struct promise_type {
+        std::exception_ptr exception;
+
+        CoreTask get_return_object() { return CoreTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        // cores start suspended and are only run by an executor
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    // run the core until its next suspension point: returns false once it has finished its trace
+    bool resume();
+
+    CoreTask(CoreTask&& other) noexcept;
+    CoreTask& operator=(CoreTask&& other) = delete;
+    ~CoreTask();
+private:
+    explicit CoreTask(std::coroutine_handle<promise_type> _handle);
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// resumes all cores on the calling thread, always picking the core whose clock is furthest behind
+class ClockOrderedExecutor {
+public:
+    void run(std::vector<CoreTask>& tasks);
+
+    // clock_of returns the current clock of a core by index
+    explicit ClockOrderedExecutor(std::function<long long(int)> _clock_of);
+private:
+    std::function<long long(int)> clock_of;
+};
+
+// resumes cores on a pool of host threads: each thread runs the cores in its own queue round-robin
+// and steals from the other queues when its own runs dry
+class WorkStealingExecutor {
+public:
+    void run(std::vector<CoreTask>& tasks);
+    // run each host thread's work loop through wrapper(thread index, loop), e.g. to measure the thread
+    void set_thread_wrapper(std::function<void(int, const std::function<void()>&)> _thread_wrapper);
+
+    explicit WorkStealingExecutor(int _num_threads);
+private:
+    int num_threads;
+    std::function<void(int, const std::function<void()>&)> thread_wrapper;
+};
+
+#endif //EXECUTOR_H
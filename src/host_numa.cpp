@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "host_numa.h"
+
+namespace {
+    // a sysfs CPU list, e.g. "0-3,8-11"
+    std::vector<int> parse_cpu_list(const std::string& list) {
+        std::vector<int> cpus;
+        std::stringstream ss(list);
+        std::string range;
+        while (std::getline(ss, range, ',')) {
+            int first, last;
+            size_t dash = range.find('-');
+            try {
+                first = std::stoi(range.substr(0, dash));
+                last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            } catch (const std::exception&) {
+                continue;
+            }
+            for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+}
+
+HostTopology::HostTopology() {
+    for (int node = 0;; node++) {
+        std::ifstream infile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!infile) break;
+        std::string list;
+        std::getline(infile, list);
+        node_cpus.push_back(parse_cpu_list(list));
+    }
+    if (node_cpus.empty()) {
+        node_cpus.emplace_back();
+        for (int cpu = 0; cpu < static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)); cpu++) {
+            node_cpus[0].push_back(cpu);
+        }
+    }
+
+    for (int node = 0; node < static_cast<int>(node_cpus.size()); node++) {
+        for (int cpu : node_cpus[node]) {
+            if (cpu >= static_cast<int>(cpu_nodes.size())) cpu_nodes.resize(cpu + 1, -1);
+            cpu_nodes[cpu] = node;
+        }
+    }
+}
+
+int HostTopology::get_num_nodes() const {
+    return static_cast<int>(node_cpus.size());
+}
+
+int HostTopology::get_node(int cpu) const {
+    if (cpu < 0 || cpu >= static_cast<int>(cpu_nodes.size()) || cpu_nodes[cpu] < 0) return 0;
+    return cpu_nodes[cpu];
+}
+
+int HostTopology::choose_cpu(int thread, PinPolicy policy, const std::vector<int>& cpus) const {
+    if (policy == PinList && !cpus.empty()) return cpus[thread % cpus.size()];
+
+    if (policy == PinSpread) {
+        // skip nodes without CPUs, e.g. memory-only nodes
+        std::vector<const std::vector<int>*> nodes;
+        for (const std::vector<int>& node : node_cpus) {
+            if (!node.empty()) nodes.push_back(&node);
+        }
+        if (nodes.empty()) return 0;
+        const std::vector<int>& node = *nodes[thread % nodes.size()];
+        return node[(thread / nodes.size()) % node.size()];
+    }
+
+    std::vector<int> all_cpus;
+    for (const std::vector<int>& node : node_cpus) all_cpus.insert(all_cpus.end(), node.begin(), node.end());
+    return all_cpus.empty() ? 0 : all_cpus[thread % all_cpus.size()];
+}
+
+std::string HostTopology::describe() const {
+    size_t num_cpus = 0;
+    for (const std::vector<int>& node : node_cpus) num_cpus += node.size();
+    return std::to_string(node_cpus.size()) + (node_cpus.size() == 1 ? " NUMA node, " : " NUMA nodes, ")
+           + std::to_string(num_cpus) + " CPUs";
+}
+
+std::string HostTopology::get_policy_str(PinPolicy policy) {
+    switch (policy) {
+    case PinCompact:
+        return "compact";
+    case PinSpread:
+        return "spread";
+    case PinList:
+        return "CPU list";
+    case NoPinning:
+    default:
+        return "none";
+    }
+}
+
+bool pin_current_thread(int cpu, std::string& error) {
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        error = "CPU " + std::to_string(cpu) + " is out of range";
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (result != 0) {
+        error = "pthread_setaffinity_np(CPU " + std::to_string(cpu) + "): " + std::strerror(result);
+        return false;
+    }
+    return true;
+#else
+    error = "thread pinning is only available on Linux";
+    return false;
+#endif
+}
+
+bool place_on_node(const void* data, size_t size, int node, bool huge_pages, std::string& error) {
+#ifdef __linux__
+    // only the pages the range covers entirely: the partial pages at its ends are shared with other data
+    const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = (reinterpret_cast<uintptr_t>(data) + page_size - 1) & ~(page_size - 1);
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(data) + size) & ~(page_size - 1);
+    if (end <= begin) return true;
+    void* start = reinterpret_cast<void*>(begin);
+    const size_t length = end - begin;
+
+    if (huge_pages && madvise(start, length, MADV_HUGEPAGE) != 0) {
+        error = std::string("madvise(MADV_HUGEPAGE): ") + std::strerror(errno);
+        return false;
+    }
+
+    constexpr int MASK_BITS = 8 * sizeof(unsigned long);
+    if (node < 0 || node >= MASK_BITS) {
+        error = "NUMA node " + std::to_string(node) + " is out of range";
+        return false;
+    }
+    // called through syscall, so that the simulator does not depend on libnuma
+    unsigned long node_mask = 1ul << node;
+    if (syscall(SYS_mbind, start, length, MPOL_BIND, &node_mask, MASK_BITS, MPOL_MF_MOVE) != 0) {
+        error = std::string("mbind: ") + std::strerror(errno);
+        return false;
+    }
+    return true;
+#else
+    error = "NUMA placement is only available on Linux";
+    return false;
+#endif
+}
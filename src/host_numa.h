@@ -0,0 +1,37 @@
+#ifndef HOST_NUMA_H
+#define HOST_NUMA_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "enums.h"
+
+// NUMA nodes of the host and the CPUs on each, read from sysfs; a host without NUMA information is one node
+// holding every hardware thread
+class HostTopology {
+public:
+    [[nodiscard]] int get_num_nodes() const;
+    // node of a host CPU, 0 if the CPU is unknown
+    [[nodiscard]] int get_node(int cpu) const;
+    // host CPU for simulation thread i: compact fills the CPUs of one node before the next, spread deals the
+    // threads out over the nodes in turn, and a list names the CPUs (reused from the start if too short)
+    [[nodiscard]] int choose_cpu(int thread, PinPolicy policy, const std::vector<int>& cpus) const;
+    // "<n> NUMA node(s), <m> CPUs"
+    [[nodiscard]] std::string describe() const;
+    static std::string get_policy_str(PinPolicy policy);
+
+    HostTopology();
+private:
+    std::vector<std::vector<int>> node_cpus;
+    // indexed by CPU, -1 for CPUs on no node
+    std::vector<int> cpu_nodes;
+};
+
+// pin the calling thread to a host CPU: false, with the reason in error, if the host refuses
+bool pin_current_thread(int cpu, std::string& error);
+// bind the whole pages of [data, data + size) to a node, moving those already allocated elsewhere, and
+// optionally ask for transparent huge pages: false, with the reason in error, if the host refuses
+bool place_on_node(const void* data, size_t size, int node, bool huge_pages, std::string& error);
+
+#endif //HOST_NUMA_H
@@ -0,0 +1,96 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "host_perf.h"
+
+#ifdef __linux__
+namespace {
+    constexpr uint64_t counter_configs[] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    // a disabled user-space counter of the calling thread, on whichever CPU it runs
+    int open_counter(uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+}
+#endif
+
+HostPerfCounters::HostPerfCounters() {
+    for (int& fd : fds) fd = -1;
+#ifdef __linux__
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        fds[i] = open_counter(counter_configs[i]);
+        if (fds[i] < 0 && error.empty()) error = std::string("perf_event_open: ") + std::strerror(errno);
+    }
+#else
+    error = "perf_event_open is only available on Linux";
+#endif
+}
+
+HostPerfCounters::~HostPerfCounters() {
+#ifdef __linux__
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+bool HostPerfCounters::is_available() const {
+    for (int fd : fds) {
+        if (fd >= 0) return true;
+    }
+    return false;
+}
+
+const std::string& HostPerfCounters::get_error() const {
+    return error;
+}
+
+void HostPerfCounters::start() {
+#ifdef __linux__
+    for (int fd : fds) {
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+HostCounters HostPerfCounters::stop(const std::string& thread) {
+    long long values[NUM_COUNTERS] = {-1, -1, -1, -1};
+#ifdef __linux__
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        if (fds[i] < 0) continue;
+        ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+        // {value, time enabled, time running}
+        uint64_t data[3];
+        if (read(fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) continue;
+        values[i] = static_cast<long long>(data[2] < data[1]
+                                           ? static_cast<double>(data[0]) * data[1] / data[2]
+                                           : data[0]);
+    }
+#endif
+    return HostCounters{thread, values[0], values[1], values[2], values[3]};
+}
@@ -0,0 +1,37 @@
+#ifndef HOST_PERF_H
+#define HOST_PERF_H
+
+#include <string>
+
+// hardware counters of one host thread over the simulation loop; a counter is -1 if the host could not provide it
+struct HostCounters {
+    std::string thread;
+    long long cycles = -1;
+    long long instructions = -1;
+    long long cache_misses = -1;
+    long long branch_misses = -1;
+};
+
+// perf_event_open counters of the calling thread, counting between start() and stop()
+class HostPerfCounters {
+public:
+    // false if no counter could be opened, e.g. due to perf_event_paranoid or a missing PMU;
+    // error then describes why
+    [[nodiscard]] bool is_available() const;
+    [[nodiscard]] const std::string& get_error() const;
+    void start();
+    // stop counting and read the counters, scaled for the time they were multiplexed out
+    HostCounters stop(const std::string& thread);
+
+    HostPerfCounters();
+    ~HostPerfCounters();
+    HostPerfCounters(const HostPerfCounters&) = delete;
+    HostPerfCounters& operator=(const HostPerfCounters&) = delete;
+private:
+    // cycles, instructions, cache misses, branch misses
+    static constexpr int NUM_COUNTERS = 4;
+    int fds[NUM_COUNTERS];
+    std::string error;
+};
+
+#endif //HOST_PERF_H
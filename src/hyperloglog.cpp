@@ -0,0 +1,49 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "hyperloglog.h"
+
+namespace {
+    // splitmix64 finalizer: spreads consecutive block addresses over all 64 bits
+    uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+}
+
+HyperLogLog::HyperLogLog(int _precision) : precision(_precision), registers(1u << _precision, 0) {}
+
+void HyperLogLog::add(uint64_t value) {
+    uint64_t hash = mix(value);
+    uint64_t index = hash >> (64 - precision);
+    // rank of the first set bit in the remaining bits; a sentinel bit bounds it when they are all zero
+    uint64_t rest = (hash << precision) | (1ULL << (precision - 1));
+    auto rank = static_cast<uint8_t>(std::countl_zero(rest) + 1);
+    registers[index] = std::max(registers[index], rank);
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    for (size_t i = 0; i < registers.size(); i++) registers[i] = std::max(registers[i], other.registers[i]);
+}
+
+double HyperLogLog::estimate() const {
+    const double m = static_cast<double>(registers.size());
+    double sum = 0;
+    int zeros = 0;
+    for (uint8_t r : registers) {
+        sum += std::ldexp(1.0, -r);
+        if (r == 0) zeros++;
+    }
+    double alpha = 0.7213 / (1 + 1.079 / m);
+    double raw = alpha * m * m / sum;
+    // linear counting is more accurate while many registers are still empty
+    if (raw <= 2.5 * m && zeros > 0) return m * std::log(m / zeros);
+    return raw;
+}
+
+void HyperLogLog::clear() {
+    std::fill(registers.begin(), registers.end(), 0);
+}
@@ -0,0 +1,23 @@
+#ifndef HYPERLOGLOG_H
+#define HYPERLOGLOG_H
+
+#include <cstdint>
+#include <vector>
+
+// HyperLogLog sketch: estimates the number of distinct values added to it in 2^precision bytes,
+// with a standard error of about 1.04 / sqrt(2^precision)
+class HyperLogLog {
+public:
+    void add(uint64_t value);
+    // fold another sketch of the same precision into this one, estimating the union
+    void merge(const HyperLogLog& other);
+    [[nodiscard]] double estimate() const;
+    void clear();
+
+    explicit HyperLogLog(int _precision);
+private:
+    int precision;
+    std::vector<uint8_t> registers;
+};
+
+#endif //HYPERLOGLOG_H
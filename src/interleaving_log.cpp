@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "interleaving_log.h"
+
+namespace {
+    constexpr uint32_t LOG_MAGIC = 0x4c494343; // "CCIL"
+    constexpr uint32_t LOG_VERSION = 1;
+
+    struct LogHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t num_cores;
+        uint32_t reserved;
+        uint64_t num_runs;
+    };
+
+    // LEB128: seven bits per byte, low bits first, the high bit set on all but the last byte
+    void write_varint(std::ostream& out, uint64_t value) {
+        char bytes[10];
+        int count = 0;
+        do {
+            bytes[count] = static_cast<char>(value & 0x7f);
+            value >>= 7;
+            if (value != 0) bytes[count] = static_cast<char>(bytes[count] | 0x80);
+            count++;
+        } while (value != 0);
+        out.write(bytes, count);
+    }
+
+    bool read_varint(std::istream& in, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            int byte = in.get();
+            if (byte == EOF) return false;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+}
+
+InterleavingLog::InterleavingLog() : next_sequence(0), num_cores(0) {}
+
+void InterleavingLog::begin_recording(int _num_cores) {
+    num_cores = _num_cores;
+    next_sequence = 0;
+    buffers.assign(num_cores, std::vector<Span>());
+    runs.clear();
+}
+
+std::mutex& InterleavingLog::get_order_lock() {
+    return order_lock;
+}
+
+void InterleavingLog::record(int core) {
+    uint64_t sequence = next_sequence++;
+    std::vector<Span>& buffer = buffers[core];
+    // a thread that takes the lock again before any other extends its current span
+    if (!buffer.empty() && buffer.back().first + buffer.back().count == sequence) {
+        buffer.back().count++;
+    } else {
+        buffer.push_back(Span{sequence, 1});
+    }
+}
+
+void InterleavingLog::end_recording() {
+    // the spans of all cores tile the sequence numbers, so sorting them by first number merges the buffers
+    std::vector<std::pair<Span, int>> spans;
+    for (int core = 0; core < num_cores; core++) {
+        for (const Span& span : buffers[core]) spans.emplace_back(span, core);
+    }
+    std::sort(spans.begin(), spans.end(), [](const auto& a, const auto& b) { return a.first.first < b.first.first; });
+
+    runs.clear();
+    runs.reserve(spans.size());
+    for (const auto& [span, core] : spans) runs.push_back(Run{core, span.count});
+    std::vector<std::vector<Span>>().swap(buffers);
+}
+
+int InterleavingLog::get_num_cores() const {
+    return num_cores;
+}
+
+const std::vector<InterleavingLog::Run>& InterleavingLog::get_runs() const {
+    return runs;
+}
+
+uint64_t InterleavingLog::get_num_steps() const {
+    uint64_t steps = 0;
+    for (const Run& run : runs) steps += run.steps;
+    return steps;
+}
+
+bool InterleavingLog::save(const std::string& path) const {
+    std::ofstream outfile(path, std::ios::binary | std::ios::trunc);
+    if (!outfile) {
+        std::cerr << "Error: Unable to write interleaving log '" << path << "'." << std::endl;
+        return false;
+    }
+
+    LogHeader header{LOG_MAGIC, LOG_VERSION, static_cast<uint32_t>(num_cores), 0, runs.size()};
+    outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const Run& run : runs) {
+        write_varint(outfile, static_cast<uint64_t>(run.core));
+        write_varint(outfile, run.steps);
+    }
+    return static_cast<bool>(outfile);
+}
+
+bool InterleavingLog::load(const std::string& path) {
+    std::ifstream infile(path, std::ios::binary);
+    if (!infile) {
+        std::cerr << "Error: Unable to open interleaving log '" << path << "'." << std::endl;
+        return false;
+    }
+
+    LogHeader header{};
+    infile.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!infile || header.magic != LOG_MAGIC || header.version != LOG_VERSION) {
+        std::cerr << "Error: '" << path << "' is not an interleaving log." << std::endl;
+        return false;
+    }
+
+    num_cores = static_cast<int>(header.num_cores);
+    runs.clear();
+    for (uint64_t i = 0; i < header.num_runs; i++) {
+        uint64_t core, steps;
+        if (!read_varint(infile, core) || !read_varint(infile, steps) || core >= header.num_cores) {
+            std::cerr << "Error: Truncated interleaving log '" << path << "'." << std::endl;
+            runs.clear();
+            return false;
+        }
+        runs.push_back(Run{static_cast<int>(core), steps});
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef INTERLEAVING_LOG_H
+#define INTERLEAVING_LOG_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// the global order in which the cores of a threaded run took their ordered steps (every instruction that
+// touches the memory system, and the final drain of each core), so that the run can be replayed exactly.
+// While recording, each core's thread takes its ordered steps under the order lock and appends the sequence
+// numbers they get to a buffer of its own; the buffers are merged by sequence number once the run ends.
+class InterleavingLog {
+public:
+    // consecutive ordered steps of one core
+    struct Run {
+        int core;
+        uint64_t steps;
+    };
+
+    // drop any previous order and start recording the steps of num_cores cores
+    void begin_recording(int num_cores);
+    // held by a core's thread for the whole of each ordered step
+    std::mutex& get_order_lock();
+    // the next ordered step is core's: call with the order lock held
+    void record(int core);
+    // merge the buffers of the cores into runs in global order
+    void end_recording();
+
+    [[nodiscard]] int get_num_cores() const;
+    [[nodiscard]] const std::vector<Run>& get_runs() const;
+    [[nodiscard]] uint64_t get_num_steps() const;
+    // the runs as varints after a small header
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    InterleavingLog();
+private:
+    // sequence numbers first, first + 1, ..., first + count - 1 went to the same core
+    struct Span {
+        uint64_t first;
+        uint64_t count;
+    };
+
+    std::mutex order_lock;
+    uint64_t next_sequence;
+    // per core, only ever touched by the core's thread
+    std::vector<std::vector<Span>> buffers;
+
+    int num_cores;
+    std::vector<Run> runs;
+};
+
+#endif //INTERLEAVING_LOG_H
@@ -0,0 +1,98 @@
+#include <cmath>
+#include <cstdio>
+
+#include "json_writer.h"
+
+JsonWriter::JsonWriter(std::ostream& _out) : out(_out), after_key(false) {}
+
+void JsonWriter::separate() {
+    if (after_key) {
+        after_key = false;
+        return;
+    }
+    if (!first.empty()) {
+        if (!first.back()) out << ',';
+        first.back() = false;
+    }
+}
+
+JsonWriter& JsonWriter::begin_object() {
+    separate();
+    out << '{';
+    first.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::end_object() {
+    out << '}';
+    first.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::begin_array() {
+    separate();
+    out << '[';
+    first.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::end_array() {
+    out << ']';
+    first.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const std::string& name) {
+    value(name);
+    out << ':';
+    after_key = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const std::string& value) {
+    separate();
+    out << '"';
+    for (char c : value) {
+        switch (c) {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out << escaped;
+            } else {
+                out << c;
+            }
+        }
+    }
+    out << '"';
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* value) {
+    return this->value(std::string(value));
+}
+
+JsonWriter& JsonWriter::value(long long value) {
+    separate();
+    out << value;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double value) {
+    separate();
+    // JSON has no representation of infinity or NaN
+    if (std::isfinite(value)) out << value;
+    else out << "null";
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool value) {
+    separate();
+    out << (value ? "true" : "false");
+    return *this;
+}
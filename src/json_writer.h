@@ -0,0 +1,42 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// streams compact JSON to an output stream, inserting the commas between members and elements
+class JsonWriter {
+public:
+    JsonWriter& begin_object();
+    JsonWriter& end_object();
+    JsonWriter& begin_array();
+    JsonWriter& end_array();
+    // name of the next member of the current object
+    JsonWriter& key(const std::string& name);
+    JsonWriter& value(const std::string& value);
+    JsonWriter& value(const char* value);
+    JsonWriter& value(long long value);
+    JsonWriter& value(double value);
+    JsonWriter& value(bool value);
+    // shorthand for key(name).value(value)
+    template <typename T>
+    JsonWriter& member(const std::string& name, const T& value) {
+        key(name);
+        if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) return this->value(static_cast<long long>(value));
+        else return this->value(value);
+    }
+
+    explicit JsonWriter(std::ostream& _out);
+private:
+    // write the comma before a value, unless it is the first in its object or array or follows a key
+    void separate();
+
+    std::ostream& out;
+    // for each open object or array, whether it has no elements yet
+    std::vector<bool> first;
+    bool after_key;
+};
+
+#endif //JSON_WRITER_H
@@ -1,49 +1,336 @@
-#include "cpu.h"
-#include "trace.h"
-#include "memory.h"
-#include "bus.h"
+#include <filesystem>
+#include <thread>
+
+#include "simulator.h"
+#include "profiler.h"
 #include "config.h"
+#include "decoded_trace.h"
+#include "synthetic_trace.h"
+#include "sim_config.h"
+#include "server.h"
+#include "checker.h"
+#include "analyzer.h"
+#include "buffer_trace.h"
+#include "interleaving_log.h"
+#include "host_numa.h"
 
-#define NUM_PROCESSORS 4
+static void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " <protocol> <filename|synthetic:<pattern>> <cache_size> <associativity> <block_size> [options]" << std::endl;
+    std::cerr << "       " << program << " --config=<file> [<filename|synthetic:<pattern>>] [options]" << std::endl;
+    std::cerr << "       " << program << " <protocol> <filename|synthetic:<pattern>> <cache_size> <associativity> <block_size>"
+              << " --check[=<reproducer prefix>] [options]" << std::endl;
+    std::cerr << "       " << program << " analyze <filename|synthetic:<pattern>> [--block-size=<bytes>] [--cache-size=<bytes>]"
+              << " [--window=<accesses>] [--cores=<n>]" << std::endl;
+    std::cerr << "       " << program << " --serve[=<socket>] [--workers=<n>] [--trace-cache=<bytes, e.g. 512M>] [options]" << std::endl;
+    std::cerr << "Options: [--prefetcher=next-line|stride|stream] [--store-buffer=<entries>]"
+              << " [--mshrs=<registers>] [--overlap-window=<cycles>] [--victim-cache=<entries>] [--sectors=<per line>]"
+              << " [--dram=open|closed] [--dram-channels=<n>] [--dram-banks=<n>]"
+              << " [--interconnect=bus|mesh] [--mesh-width=<tiles>] [--mesh-height=<tiles>] [--hop-time=<cycles>]"
+              << " [--link-width=<bytes>] [--llc-slice-size=<bytes>] [--llc-associativity=<n>] [--llc-hit-time=<cycles>]"
+              << " [--predecode] [--decode-cache=<directory>] [--length=<instructions>] [--seed=<n>]"
+              << " [--cores=<n>] [--cache-hit-time=<cycles>] [--send-word-time=<cycles>]"
+              << " [--mem-fetch-time=<cycles>] [--mem-flush-time=<cycles>] [--victim-hit-time=<cycles>]"
+              << " [--core<n>.<cache-size|associativity|cache-hit-time|send-word-time|victim-hit-time>=<value>]"
+              << " [--executor=threads|serial|coroutines] [--host-threads=<n>] [--host-perf]"
+              << " [--record=<interleaving log>] [--replay=<interleaving log>]"
+              << " [--pin=compact|spread|<cpu,cpu,...>] [--huge-pages]"
+              << " [--tlb] [--tlb-l1-entries=<n>] [--tlb-l2-entries=<n>] [--page-size=<bytes, e.g. 4K or 2M>]" << std::endl;
+    std::cerr << "Every option can also be set as 'key = value' in the configuration file, e.g. 'store_buffer = 8'."
+              << std::endl;
+    std::cerr << "In server mode each line read from stdin or the socket is a job of 'key=value' options, e.g."
+              << " 'id=1 trace=traces/bodytrack protocol=Dragon', answered by a line of JSON." << std::endl;
+    std::cerr << "Synthetic patterns: sequential, strided, uniform, zipfian, producer-consumer, migratory, lock"
+              << std::endl;
+}
 
-int main(int argc, char* argv[]) {
-    if (argc != 6) {
-        std::cerr << "Usage: " << argv[0] << " <protocol> <filename> <cache_size> <associativity> <block_size>" << std::endl;
+// run the optimized and the reference engine in lockstep on the traces, writing a reproducer of the first divergence
+static int run_check(const SimConfig& config, std::vector<Trace*>& traces, const std::string& reproducer_prefix) {
+    std::string unsupported = DifferentialChecker::get_unsupported_option(config);
+    if (!unsupported.empty()) {
+        std::cerr << "The reference engine does not model --" << unsupported << "." << std::endl;
         return EXIT_FAILURE;
     }
 
-    // arguments
-    Protocol protocol = std::strcmp(argv[1], "Dragon") == 0 ? Dragon : MESI;
-    std::string filename = argv[2];
-    int cache_size = atoi(argv[3]);
-    int associativity = atoi(argv[4]);
-    int block_size = atoi(argv[5]);
+    DifferentialChecker checker(config);
+    std::vector<CheckEvent> events = DifferentialChecker::interleave(traces);
+    std::cout << "Checking " << events.size() << " instructions of " << traces.size() << " cores against the reference engine..." << std::endl;
+    Divergence divergence;
+    if (checker.check(events, divergence)) {
+        std::cout << "No divergence." << std::endl;
+        return EXIT_SUCCESS;
+    }
 
-    Bus bus(block_size);
+    std::cout << "Divergence at instruction " << divergence.event << ": " << divergence.description << std::endl;
+    std::vector<CheckEvent> reproducer = checker.reduce(events, divergence);
+    if (DifferentialChecker::write_reproducer(reproducer, static_cast<int>(traces.size()), reproducer_prefix)) {
+        checker.check(reproducer, divergence);
+        std::cout << "Reproducer of " << reproducer.size() << " accesses written to '" << reproducer_prefix << "_<core>.data': "
+                  << divergence.description << std::endl;
+    }
+    return EXIT_FAILURE;
+}
 
-    CPU cpu;
-    cpu.connect_bus(&bus);
+int main(int argc, char* argv[]) {
+    // the configuration file is read first, so that positional arguments and options override it
+    SimConfig config;
+    std::string error;
+    std::vector<std::string> positional;
+    std::vector<std::pair<std::string, std::string>> options;
+    bool serve = false;
+    std::string socket_path;
+    bool check = false;
+    std::string reproducer_prefix = "divergence";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            positional.push_back(arg);
+            continue;
+        }
+        size_t equals = arg.find('=');
+        std::string key = arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2);
+        std::string value = equals == std::string::npos ? "true" : arg.substr(equals + 1);
+        if (key == "check") {
+            check = true;
+            if (equals != std::string::npos) reproducer_prefix = value;
+        } else if (key == "serve") {
+            serve = true;
+            if (equals != std::string::npos) socket_path = value;
+        } else if (key == "config") {
+            if (!config.load_file(value, error)) {
+                std::cerr << error << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else {
+            options.emplace_back(key, value);
+        }
+    }
 
-    for (int i = 0; i < NUM_PROCESSORS; i++) {
-        std::string core_filename = filename + "_" + std::to_string(i) + ".data";
-        if (!std::filesystem::exists(core_filename)) break;
-        // read data from file
-        Trace* trace = new Trace();
-        if (!trace->read_data(core_filename)) {
+    // "analyze" characterizes the traces instead of simulating them
+    bool analyze = !positional.empty() && positional[0] == "analyze";
+    if (analyze) positional.erase(positional.begin());
+
+    // either all five positional arguments, only the trace, or none when the configuration file names the trace
+    static const char* positional_keys[] = {"protocol", "trace", "cache_size", "associativity", "block_size"};
+    if (positional.size() == 5 && !analyze) {
+        for (size_t i = 0; i < positional.size(); i++) {
+            if (!config.set(positional_keys[i], positional[i], error)) {
+                std::cerr << error << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    } else if (positional.size() == 1) {
+        config.trace = positional[0];
+    } else if (!positional.empty()) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    for (const auto& [key, value] : options) {
+        if (!config.set(key, value, error)) {
+            std::cerr << error << std::endl;
             return EXIT_FAILURE;
         }
+    }
+    if (serve) {
+        Server server(config, config.server_workers > 0 ? config.server_workers
+                                                        : static_cast<int>(std::thread::hardware_concurrency()),
+                      static_cast<size_t>(config.trace_cache_size));
+        if (!socket_path.empty()) return server.serve_socket(socket_path) ? EXIT_SUCCESS : EXIT_FAILURE;
+        // stdout carries the results, so progress messages go to stderr
+        std::streambuf* results = std::cout.rdbuf(std::cerr.rdbuf());
+        std::ostream out(results);
+        server.serve_stream(std::cin, out);
+        std::cout.rdbuf(results);
+        return EXIT_SUCCESS;
+    }
+    if (config.trace.empty()) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
 
-        // set up memory
-        Memory* memory = new Memory(i, cache_size, associativity, block_size, Config::ADDRESS_BITS, protocol);
-        bus.connect_memory(memory);
+    // "synthetic:<pattern>" generates the traces of all cores instead of reading them from files
+    bool synthetic = config.trace.rfind("synthetic:", 0) == 0;
+    SyntheticPattern synthetic_pattern = Sequential;
+    if (synthetic) {
+        std::string value = config.trace.substr(std::strlen("synthetic:"));
+        if (!SyntheticTrace::parse_pattern(value, synthetic_pattern)) {
+            std::cerr << "Unknown synthetic pattern '" << value << "'." << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (config.predecode) {
+            std::cerr << "Synthetic traces are generated on the fly and cannot be predecoded." << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
 
-        cpu.add_core(trace, memory);
+    if (!config.validate(error)) {
+        std::cerr << error << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (!config.record_interleaving.empty() && (config.executor != ThreadPerCore || !config.replay_interleaving.empty())) {
+        std::cerr << "Only threaded runs (--executor=threads) can be recorded." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (analyze) {
+        // trace files are streamed rather than loaded, so traces larger than memory can be analyzed
+        std::vector<Trace*> traces;
+        for (int i = 0; i < config.cores; i++) {
+            if (synthetic) {
+                traces.push_back(new SyntheticTrace(synthetic_pattern, i, config.synthetic_length, config.synthetic_seed));
+                continue;
+            }
+            std::string core_filename = config.trace + "_" + std::to_string(i) + ".data";
+            if (!std::filesystem::exists(core_filename)) break;
+            auto* trace = new StreamTrace(core_filename);
+            if (!trace->is_open()) {
+                delete trace;
+                return EXIT_FAILURE;
+            }
+            traces.push_back(trace);
+        }
+        std::cout << "Analyzing " << traces.size() << " traces with " << config.block_size << " byte blocks..." << std::endl;
+        TraceAnalyzer analyzer(config.block_size, config.cache_size, config.analysis_window);
+        analyzer.run(traces);
+        analyzer.print();
+        for (Trace* trace : traces) delete trace;
+        return EXIT_SUCCESS;
+    }
+
+    if (check) {
+        std::vector<Trace*> traces;
+        for (int i = 0; i < config.cores; i++) {
+            if (synthetic) {
+                traces.push_back(new SyntheticTrace(synthetic_pattern, i, config.synthetic_length, config.synthetic_seed));
+                continue;
+            }
+            std::string core_filename = config.trace + "_" + std::to_string(i) + ".data";
+            if (!std::filesystem::exists(core_filename)) break;
+            Trace* trace = new Trace();
+            if (!trace->read_data(core_filename)) {
+                delete trace;
+                return EXIT_FAILURE;
+            }
+            traces.push_back(trace);
+        }
+        int status = run_check(config, traces, reproducer_prefix);
+        for (Trace* trace : traces) delete trace;
+        return status;
+    }
+
+    Simulator simulator(config);
+    for (int i = 0; i < config.cores; i++) {
+        if (synthetic) {
+            simulator.add_core(new SyntheticTrace(synthetic_pattern, i, config.synthetic_length, config.synthetic_seed));
+            continue;
+        }
+
+        std::string core_filename = config.trace + "_" + std::to_string(i) + ".data";
+        if (!std::filesystem::exists(core_filename)) break;
+
+        if (!config.predecode) {
+            // read data from file
+            Trace* trace = new Trace();
+            if (!trace->read_data(core_filename)) {
+                return EXIT_FAILURE;
+            }
+            simulator.add_core(trace);
+            std::cout << std::endl;
+            continue;
+        }
+
+        // decode the trace for this cache geometry, reusing a cached decoding of the same file if there is one
+        int offset_bits = simulator.get_offset_bits();
+        int set_index_bits = simulator.get_set_index_bits();
+        DecodedTrace* decoded = new DecodedTrace();
+        uint64_t trace_hash = 0;
+        std::string cache_path;
+        if (!config.decode_cache_dir.empty() && DecodedTrace::hash_file(core_filename, trace_hash)) {
+            cache_path = DecodedTrace::get_cache_path(config.decode_cache_dir, core_filename, trace_hash, offset_bits, set_index_bits);
+        }
+        if (cache_path.empty() || !decoded->load_cache(cache_path, trace_hash, offset_bits, set_index_bits)) {
+            Trace trace;
+            if (!trace.read_data(core_filename)) {
+                delete decoded;
+                return EXIT_FAILURE;
+            }
+            decoded->decode(trace, offset_bits, set_index_bits);
+            if (!cache_path.empty()) decoded->save_cache(cache_path, trace_hash, offset_bits, set_index_bits);
+        }
+        simulator.add_core(decoded);
         std::cout << std::endl;
     }
 
+    InterleavingLog interleaving;
+    if (!config.replay_interleaving.empty()) {
+        if (!interleaving.load(config.replay_interleaving)) return EXIT_FAILURE;
+        simulator.replay_interleaving(&interleaving);
+    } else if (!config.record_interleaving.empty()) {
+        simulator.record_interleaving(&interleaving);
+    }
+
     // simulate
-    std::cout << "Protocol: " << (protocol == Dragon ? "Dragon" : "MESI") <<  std::endl;
-    cpu.run_parallel();
+    std::cout << "Protocol: " << (config.protocol == Dragon ? "Dragon" : "MESI") <<  std::endl;
+    std::cout << "Latencies: hit " << config.latencies.cache_hit << ", word " << config.latencies.send_word
+              << ", fetch " << config.latencies.mem_fetch << ", flush " << config.latencies.mem_flush << " cycles" << std::endl;
+    if (!config.replay_interleaving.empty()) {
+        std::cout << "Executor: replay of " << interleaving.get_num_steps() << " ordered steps from '"
+                  << config.replay_interleaving << "'" << std::endl;
+    } else if (config.executor == Coroutines) {
+        std::cout << "Executor: coroutines on " << (config.host_threads == 1 ? "1 host thread (clock ordered)"
+                  : (config.host_threads == 0 ? "all host threads" : std::to_string(config.host_threads) + " host threads (work stealing)"))
+                  << std::endl;
+    } else if (config.executor == RoundRobin) {
+        std::cout << "Executor: serial round-robin" << std::endl;
+    } else if (config.pin != NoPinning) {
+        std::cout << "Pinning: " << HostTopology::get_policy_str(config.pin) << " on " << HostTopology().describe()
+                  << (config.huge_pages ? ", traces on huge pages" : "") << std::endl;
+    }
+    if (synthetic) {
+        std::cout << "Synthetic workload: " << SyntheticTrace::get_pattern_str(synthetic_pattern) << ", "
+                  << config.synthetic_length << " instructions per core, seed " << config.synthetic_seed << std::endl;
+    }
+    if (config.prefetcher != NoPrefetcher) {
+        std::cout << "Prefetcher: " << Prefetcher::get_prefetcher_str(config.prefetcher) << std::endl;
+    }
+    if (config.store_buffer > 0) {
+        std::cout << "Store buffer: " << config.store_buffer << " entries" << std::endl;
+    }
+    if (config.mshrs > 0) {
+        std::cout << "MSHRs: " << config.mshrs << " (overlap window " << config.overlap_window << " cycles)" << std::endl;
+    }
+    if (config.use_dram) {
+        std::cout << "DRAM: " << config.dram_channels << " channels, " << config.dram_banks << " banks, "
+                  << (config.page_policy == OpenPage ? "open" : "closed") << " page" << std::endl;
+    }
+    if (config.interconnect == MeshNetwork) {
+        std::cout << "Interconnect: " << config.get_mesh_size().first << "x" << config.get_mesh_size().second
+                  << " mesh, " << config.hop_time << " cycles per hop, " << config.link_width << "-byte links";
+        if (config.llc_slice_size > 0) {
+            std::cout << ", " << config.llc_slice_size << "-byte " << config.llc_associativity << "-way LLC slices (hit "
+                      << config.llc_hit_time << " cycles)";
+        }
+        std::cout << std::endl;
+    }
+    if (config.sectors > 1) {
+        std::cout << "Sectors: " << config.sectors << " per line, " << config.block_size / config.sectors << " bytes each" << std::endl;
+    }
+    if (config.victim_cache > 0) {
+        std::cout << "Victim cache: " << config.victim_cache << " entries" << std::endl;
+    }
+    if (config.tlb) {
+        std::cout << "TLB: " << config.tlb_l1_entries << " L1 entries, " << config.tlb_l2_entries << " L2 entries, "
+                  << config.page_size << " byte pages" << std::endl;
+    }
+
+    std::cout << "Running CPU simulation..." << std::endl;
+    SimulationStats stats = simulator.run();
+    std::cout << "Simulation finished! (" << stats.host_time_ms << "ms)" << std::endl << std::endl;
+    if (!config.record_interleaving.empty()) {
+        if (!interleaving.save(config.record_interleaving)) return EXIT_FAILURE;
+        std::cout << "Interleaving of " << interleaving.get_num_steps() << " ordered steps (" << interleaving.get_runs().size()
+                  << " runs) recorded to '" << config.record_interleaving << "'" << std::endl << std::endl;
+    }
+    Profiler::print_stats(stats);
 
     return 0;
 }
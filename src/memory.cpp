@@ -4,41 +4,496 @@
 #include "config.h"
 
 Memory::Memory(int _index, int cache_size, int associativity, int block_size, int address_bits = 32, Protocol _protocol = MESI) :
-        cache_size(cache_size), associativity(associativity), block_size(block_size) {
+        cache_size(cache_size), associativity(associativity), block_size(block_size), sector_size(block_size),
+        num_sets(cache_size / (block_size * associativity)), cache(num_sets, associativity, _protocol),
+        clock(0), drain_clock(0), page_bits(0), page_table_levels(0), profiling(true) {
     core_index = _index;
     protocol = _protocol;
 
-    int num_sets = cache_size / (block_size * associativity);
-    cache.reserve(num_sets);
-    for (size_t i = 0; i < num_sets; ++i) {
-        cache.emplace_back(std::make_unique<LRUSet>(associativity, _protocol));
-    }
-
     offset_bits = std::log2(block_size);
     set_index_bits = std::log2(num_sets);
     tag_bits = address_bits - offset_bits - set_index_bits;
 
-    offset_mask = (1 << offset_bits) - 1;                                 // e.g. 00000000000000000000000000001111
-    set_index_mask = ((1 << set_index_bits) - 1) << offset_bits;          // e.g. 00000000000000000000001111110000
-    tag_mask = ((1 << tag_bits) - 1) << (offset_bits + set_index_bits);   // e.g. 11111111111111111111110000000000
+    offset_mask = (1u << offset_bits) - 1;                                // e.g. 00000000000000000000000000001111
+    set_index_mask = ((1u << set_index_bits) - 1) << offset_bits;         // e.g. 00000000000000000000001111110000
+    tag_mask = ((1u << tag_bits) - 1) << (offset_bits + set_index_bits);  // e.g. 11111111111111111111110000000000
+}
+
+CacheState Memory::get_block_state(uint32_t address) const {
+    uint32_t offset, set_index, tag;
+    std::tie(offset, set_index, tag) = compute_tag_idx_offset(address);
+    LRUSet* cache_set = cache.find(set_index);
+    return cache_set == nullptr ? NotPresent : cache_set->get_state(tag, address);
+}
+
+BusResponse Memory::process_signal_from_bus(BusMessage message, uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus) {
+    // a set this core never touched holds no copy of the block
+    LRUSet* cache_set = cache.find(set_index);
+    BusResponse response = cache_set == nullptr ? NoResponse
+                                                : cache_set->process_signal_from_bus(tag, message, bus, address, core_index);
+
+    // a line is in either the main cache or the victim cache, never both
+    if (response == NoResponse && victim_cache != nullptr) {
+        response = victim_cache->process_signal_from_bus(address & ~offset_mask, message, bus, core_index);
+    }
+    return response;
+}
+
+void Memory::set_sectors(int sectors) {
+    sector_size = block_size / sectors;
+    cache.set_sectors(sectors, offset_bits - static_cast<int>(std::log2(sectors)));
+}
+
+void Memory::set_victim_cache_size(int entries) {
+    victim_cache = entries > 0 ? std::make_unique<VictimCache>(entries) : nullptr;
+}
+
+bool Memory::has_victim_cache() const {
+    return victim_cache != nullptr;
+}
+
+const VictimCacheStats& Memory::get_victim_cache_stats() const {
+    return victim_cache_stats;
+}
+
+void Memory::set_latencies(const Latencies& _latencies) {
+    latencies = _latencies;
+}
+
+int Memory::get_offset_bits() const {
+    return offset_bits;
+}
+
+int Memory::get_set_index_bits() const {
+    return set_index_bits;
+}
+
+long Memory::get_num_sets() const {
+    return num_sets;
+}
+
+int Memory::get_cache_size() const {
+    return cache_size;
+}
+
+int Memory::get_associativity() const {
+    return associativity;
+}
+
+const Latencies& Memory::get_latencies() const {
+    return latencies;
+}
+
+long Memory::get_num_allocated_sets() const {
+    return cache.get_num_allocated();
+}
+
+uint32_t Memory::address_of(uint32_t tag, uint32_t set_index) const {
+    return (tag << (offset_bits + set_index_bits)) | (set_index << offset_bits);
+}
+
+int Memory::transfer_time(uint32_t address, Bus* bus) const {
+    return latencies.send_word + bus->cache_transfer_time(address, core_index, clock);
+}
+
+std::tuple<int, BusResponse, int> Memory::allocate_line(uint32_t set_index, uint32_t tag, bool is_write, uint32_t address,
+                                                        Bus* bus) {
+    LRUSet::Line evicted;
+    BusResponse response = cache.get(set_index)->allocate(tag, is_write, bus, address, core_index, evicted);
+
+    // lines are never sectored when there is a victim cache
+    if (victim_cache != nullptr) {
+        auto [cycles, lines] = evict_to_victim_cache(evicted.tag, set_index, evicted.states[0], bus);
+        return {cycles, response, lines * block_size};
+    }
+    auto [cycles, sectors] = write_back(evicted, set_index, bus);
+    return {cycles, response, sectors * sector_size};
+}
+
+std::pair<int, int> Memory::write_back(const LRUSet::Line& line, uint32_t set_index, Bus* bus, bool timed) {
+    // each dirty sector is a transfer of its own, written back one after the other
+    int cycles = 0;
+    int sectors = 0;
+    const uint32_t line_address = address_of(line.tag, set_index);
+    for (int s = 0; s < block_size / sector_size; s++) {
+        if (!LRUSet::is_dirty(line.states[s])) continue;
+        uint32_t sector_address = line_address + static_cast<uint32_t>(s * sector_size);
+        bus->broadcast(WriteBack, sector_address, core_index, line.states[s]);
+        if (timed) cycles += bus->memory_flush_time(sector_address, core_index, clock + cycles);
+        sectors++;
+    }
+    return {cycles, sectors};
+}
+
+std::pair<int, int> Memory::evict_to_victim_cache(uint32_t tag, uint32_t set_index, CacheState state, Bus* bus) {
+    // nothing was evicted, or the evicted copy was already invalidated
+    if (state == NotPresent || state == Invalid) return {0, 0};
+
+    victim_cache_stats.insertions++;
+    uint32_t pushed_out_address;
+    CacheState pushed_out_state;
+    std::tie(pushed_out_address, pushed_out_state) = victim_cache->insert(address_of(tag, set_index), state);
+
+    // dirty lines are written back lazily, once they leave the victim cache
+    if (!LRUSet::is_dirty(pushed_out_state)) return {0, 0};
+    bus->broadcast(WriteBack, pushed_out_address, core_index, pushed_out_state);
+    victim_cache_stats.write_backs++;
+    return {bus->memory_flush_time(pushed_out_address, core_index, clock), 1};
+}
+
+bool Memory::swap_in_victim(uint32_t address, Bus* bus, int& cycles) {
+    CacheState state = victim_cache->remove(address & ~offset_mask);
+    // a copy invalidated while in the victim cache is dropped
+    if (state == NotPresent || state == Invalid) return false;
+
+    uint32_t offset, set_index, tag;
+    std::tie(offset, set_index, tag) = compute_tag_idx_offset(address);
+
+    // the line displaced from the main cache takes the freed victim cache entry
+    uint32_t evicted_tag;
+    CacheState evicted_state;
+    std::tie(evicted_tag, evicted_state) = cache.get(set_index)->insert(tag, state);
+    cycles = latencies.victim_hit + evict_to_victim_cache(evicted_tag, set_index, evicted_state, bus).first;
+    victim_cache_stats.hits++;
+    victim_cache_stats.cycles_saved += latencies.mem_fetch - latencies.victim_hit;
+    return true;
+}
+
+void Memory::set_tlb(int l1_entries, int l2_entries, int page_size) {
+    if (l1_entries <= 0) {
+        l1_tlb = nullptr;
+        l2_tlb = nullptr;
+        return;
+    }
+    l1_tlb = std::make_unique<TLB>(l1_entries);
+    l2_tlb = l2_entries > 0 ? std::make_unique<TLB>(l2_entries) : nullptr;
+    page_bits = static_cast<int>(std::log2(page_size));
+
+    // radix page table with PAGE_TABLE_INDEX_BITS per level: huge pages leave fewer bits to translate,
+    // so their walks are shorter; the entries of level l are indexed by the page number bits above it
+    int page_number_bits = Config::ADDRESS_BITS - page_bits;
+    page_table_levels = std::max(1, (page_number_bits + Config::PAGE_TABLE_INDEX_BITS - 1) / Config::PAGE_TABLE_INDEX_BITS);
+    page_table_level_offsets.assign(page_table_levels, 0);
+    uint64_t offset = 0;
+    for (int level = 0; level < page_table_levels; level++) {
+        page_table_level_offsets[level] = static_cast<uint32_t>(offset);
+        int index_bits = page_number_bits - Config::PAGE_TABLE_INDEX_BITS * (page_table_levels - 1 - level);
+        offset += (uint64_t{1} << index_bits) * Config::PAGE_TABLE_ENTRY_SIZE;
+    }
+}
+
+bool Memory::has_tlb() const {
+    return l1_tlb != nullptr;
+}
+
+const TLBStats& Memory::get_tlb_stats() const {
+    return tlb_stats;
+}
+
+int Memory::translate(uint32_t address, Bus* bus) {
+    uint32_t page = address >> page_bits;
+    if (l1_tlb->lookup(page)) {
+        // the L1 TLB is looked up in parallel with the cache
+        tlb_stats.l1_hits++;
+        return 0;
+    }
+
+    int cycles = 0;
+    if (l2_tlb != nullptr) {
+        cycles += Config::L2_TLB_HIT_TIME;
+        clock += Config::L2_TLB_HIT_TIME;
+        if (l2_tlb->lookup(page)) {
+            tlb_stats.l2_hits++;
+            tlb_stats.cycles += cycles;
+            l1_tlb->insert(page);
+            return cycles;
+        }
+    }
+
+    // page walk: read one entry per level through the cache, from the root down
+    tlb_stats.misses++;
+    int walk_cycles = 0;
+    for (int level = 0; level < page_table_levels; level++) {
+        // entries of a level are indexed by all page number bits translated so far
+        uint32_t index = page >> (Config::PAGE_TABLE_INDEX_BITS * (page_table_levels - 1 - level));
+        uint32_t entry_address = static_cast<uint32_t>(Config::PAGE_TABLE_BASE) + page_table_level_offsets[level]
+                                 + index * Config::PAGE_TABLE_ENTRY_SIZE;
+        uint32_t offset, set_index, tag;
+        std::tie(offset, set_index, tag) = compute_tag_idx_offset(entry_address);
+
+        auto [entry_cycles, is_hit, from_state, to_state] = load_from_cache(entry_address, set_index, tag, bus);
+        clock += entry_cycles;
+        walk_cycles += entry_cycles;
+        tlb_stats.walk_accesses++;
+        if (is_hit) tlb_stats.walk_cache_hits++;
+    }
+
+    tlb_stats.walk_cycles += walk_cycles;
+    cycles += walk_cycles;
+    tlb_stats.cycles += cycles;
+    if (l2_tlb != nullptr) l2_tlb->insert(page);
+    l1_tlb->insert(page);
+    return cycles;
+}
 
-    std::cout << "Memory initialized. Offset: " << offset_bits << " bits. Set Index: "
-              << set_index_bits << " bits. Tag: " << tag_bits << " bits. "
-              << num_sets << " sets, " << associativity << "-way associative." << std::endl;
+int Memory::advance_clock(int cycles) {
+    clock += cycles;
+    return mshrs != nullptr ? wait_for_window() : 0;
 }
 
-BusResponse Memory::process_signal_from_bus(BusMessage message, uint32_t address, Bus* bus) {
+void Memory::set_mshrs(int count, int overlap_window) {
+    mshrs = count > 0 ? std::make_unique<MSHRFile>(count, overlap_window) : nullptr;
+}
+
+bool Memory::has_mshrs() const {
+    return mshrs != nullptr;
+}
+
+const MSHRStats& Memory::get_mshr_stats() const {
+    return mshr_stats;
+}
+
+void Memory::set_prefetcher(std::unique_ptr<Prefetcher> _prefetcher) {
+    prefetcher = std::move(_prefetcher);
+}
+
+bool Memory::has_prefetcher() const {
+    return prefetcher != nullptr;
+}
+
+const PrefetchStats& Memory::get_prefetch_stats() const {
+    return prefetch_stats;
+}
+
+void Memory::set_store_buffer_size(int entries) {
+    store_buffer = entries > 0 ? std::make_unique<StoreBuffer>(entries) : nullptr;
+}
+
+bool Memory::has_store_buffer() const {
+    return store_buffer != nullptr;
+}
+
+const StoreBufferStats& Memory::get_store_buffer_stats() const {
+    return store_buffer_stats;
+}
+
+CacheState Memory::peek_state(uint32_t address) {
     uint32_t offset, set_index, tag;
     std::tie(offset, set_index, tag) = compute_tag_idx_offset(address);
-    std::unique_ptr<LRUSet>& cache_set = cache[set_index];
-    return cache_set->process_signal_from_bus(tag, message, bus, address, core_index);
+    LRUSet* cache_set = cache.find(set_index);
+    return cache_set == nullptr ? NotPresent : cache_set->get_state(tag, address);
+}
+
+void Memory::drain_one(Bus* bus) {
+    StoreBuffer::Entry entry = store_buffer->front();
+    store_buffer->pop();
+
+    // the drain engine writes one entry at a time, starting once the entry is retired
+    long long start = std::max(drain_clock, entry.cycle);
+    uint32_t offset, set_index, tag;
+    std::tie(offset, set_index, tag) = compute_tag_idx_offset(entry.address);
+    auto result = store_to_cache(entry.address, set_index, tag, bus);
+    int cycles = std::get<0>(result);
+    if (prefetcher != nullptr) cycles += use_prefetched(entry.block_address, std::get<1>(result), start);
+    drain_clock = start + cycles;
+}
+
+void Memory::drain_store_buffer(long long cycle, Bus* bus) {
+    while (!store_buffer->is_empty() && std::max(drain_clock, store_buffer->front().cycle) <= cycle) {
+        drain_one(bus);
+    }
+}
+
+int Memory::fence(Bus* bus) {
+    int stall = 0;
+
+    if (store_buffer != nullptr) {
+        while (!store_buffer->is_empty()) drain_one(bus);
+        if (drain_clock > clock) stall = static_cast<int>(drain_clock - clock);
+        store_buffer_stats.fence_stall_cycles += stall;
+        clock += stall;
+    }
+
+    if (mshrs != nullptr) {
+        long long ready = mshrs->last_ready();
+        if (ready > clock) {
+            stall += static_cast<int>(ready - clock);
+            clock = ready;
+        }
+        mshrs->clear();
+    }
+
+    return stall;
+}
+
+std::tuple<int, bool, CacheState, CacheState> Memory::buffer_store(uint32_t address, Bus* bus) {
+    drain_store_buffer(clock, bus);
+
+    uint32_t block_address = address & ~offset_mask;
+    store_buffer_stats.stores++;
+
+    if (store_buffer->contains(block_address)) {
+        // coalesce with the pending store to the same block
+        store_buffer_stats.coalesced++;
+        CacheState state = peek_state(address);
+        return {latencies.cache_hit, state != NotPresent && state != Invalid, state, state};
+    }
+
+    int stall = 0;
+    if (store_buffer->is_full()) {
+        // wait for the oldest entry to be written to free a slot
+        drain_one(bus);
+        if (drain_clock > clock) stall = static_cast<int>(drain_clock - clock);
+        store_buffer_stats.full_stalls++;
+        store_buffer_stats.full_stall_cycles += stall;
+    }
+
+    // the store is counted as a hit if the cache holds a valid copy when it retires;
+    // state transitions happen when the entry drains
+    CacheState state = peek_state(address);
+    bool is_hit = state != NotPresent && state != Invalid;
+    store_buffer->push(block_address, address, clock + stall);
+    return {stall + latencies.cache_hit, is_hit, state, state};
 }
 
 std::tuple<int, bool, CacheState, CacheState> Memory::load(uint32_t address, Bus* bus) {
     uint32_t offset, set_index, tag;
     std::tie(offset, set_index, tag) = compute_tag_idx_offset(address);
+    return load(address, set_index, tag, bus);
+}
+
+std::tuple<int, bool, CacheState, CacheState> Memory::load(const DecodedInstruction& ins, Bus* bus) {
+    return load(address_of(ins.tag, ins.set_index), ins.set_index, ins.tag, bus);
+}
+
+std::tuple<int, bool, CacheState, CacheState> Memory::load(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus) {
+    if (l1_tlb != nullptr) {
+        int translation_cycles = translate(address, bus);
+        auto result = load_translated(address, set_index, tag, bus);
+        std::get<0>(result) += translation_cycles;
+        return result;
+    }
+    return load_translated(address, set_index, tag, bus);
+}
+
+std::tuple<int, bool, CacheState, CacheState> Memory::load_translated(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus) {
+    if (store_buffer != nullptr) {
+        drain_store_buffer(clock, bus);
+        if (store_buffer->holds_store_to(address)) {
+            // store-to-load forwarding
+            store_buffer_stats.forwarded++;
+            CacheState state = peek_state(address);
+            clock += latencies.cache_hit;
+            return {latencies.cache_hit, true, state, state};
+        }
+    }
+
+    if (mshrs != nullptr) mshrs->retire(clock);
+
+    auto result = load_from_cache(address, set_index, tag, bus);
+    int& cycles = std::get<0>(result);
+    bool& is_hit = std::get<1>(result);
+    uint32_t block_address = address & ~offset_mask;
+
+    if (prefetcher != nullptr) cycles += use_prefetched(block_address, is_hit, clock);
+
+    if (mshrs != nullptr) {
+        const MSHRFile::Entry* pending = mshrs->find(block_address);
+        if (is_hit && pending != nullptr) {
+            // secondary miss: the block is already being fetched, merge into its register
+            mshr_stats.secondary_misses++;
+            is_hit = false;
+        } else if (!is_hit) {
+            // primary miss: hand the fill to a register and let the core carry on
+            int stall = 0;
+            if (mshrs->is_full()) {
+                long long ready = mshrs->pop_earliest();
+                if (ready > clock) stall = static_cast<int>(ready - clock);
+                mshr_stats.full_stalls++;
+                mshr_stats.full_stall_cycles += stall;
+            }
+            mshrs->allocate(block_address, clock + stall, clock + stall + cycles);
+            mshr_stats.primary_misses++;
+            mshr_stats.occupancy_sum += mshrs->size();
+            mshr_stats.max_occupancy = std::max(mshr_stats.max_occupancy, mshrs->size());
+            cycles = stall + latencies.cache_hit;
+        }
+    }
+
+    clock += cycles;
+    if (mshrs != nullptr) cycles += wait_for_window();
+
+    if (prefetcher != nullptr) {
+        prefetch_candidates.clear();
+        prefetcher->on_access(block_address, !is_hit, prefetch_candidates);
+        for (uint32_t candidate : prefetch_candidates) {
+            issue_prefetch(candidate, bus);
+        }
+    }
+
+    return result;
+}
+
+int Memory::wait_for_window() {
+    int stall = static_cast<int>(mshrs->window_stall(clock));
+    mshr_stats.window_stall_cycles += stall;
+    clock += stall;
+    return stall;
+}
+
+int Memory::use_prefetched(uint32_t block_address, bool is_hit, long long cycle) {
+    if (!is_hit) prefetch_stats.demand_misses++;
+    auto prefetched = prefetched_blocks.find(block_address);
+    if (prefetched == prefetched_blocks.end()) return 0;
+
+    int wait = 0;
+    if (is_hit) {
+        prefetch_stats.useful++;
+        if (prefetched->second > cycle) {
+            // prefetch still in flight -> wait for the rest of the fill
+            prefetch_stats.late++;
+            prefetch_stats.late_cycles += prefetched->second - cycle;
+            wait = static_cast<int>(prefetched->second - cycle);
+        }
+    }
+    // a prefetched block that misses was evicted or invalidated before use
+    prefetched_blocks.erase(prefetched);
+    return wait;
+}
+
+void Memory::issue_prefetch(uint32_t block_address, Bus* bus) {
+    uint32_t offset, set_index, tag;
+    std::tie(offset, set_index, tag) = compute_tag_idx_offset(block_address);
+
+    LRUSet* cache_set = cache.get(set_index);
+    if (cache_set->get_state(tag, block_address) != NotPresent) return;
+
+    // a block held by the victim cache is moved back without going to the bus
+    int victim_cycles;
+    if (victim_cache != nullptr && swap_in_victim(address_of(tag, set_index), bus, victim_cycles)) return;
+
+    int write_back_cycles;
+    BusResponse response;
+    int write_back_bytes;
+    std::tie(write_back_cycles, response, write_back_bytes) = allocate_line(set_index, tag, false, block_address, bus);
+
+    int cycles;
+    if (response == BusResponseShared) {
+        cycles = transfer_time(block_address, bus);
+    } else if (response == BusResponseDirty) {
+        cycles = transfer_time(block_address, bus) + bus->memory_flush_time(block_address, core_index, clock);
+    } else {
+        cycles = bus->memory_fetch_time(block_address, core_index, clock);
+    }
+    cycles += write_back_cycles;
+
+    prefetch_stats.issued++;
+    prefetch_stats.traffic += sector_size + write_back_bytes;
+    prefetched_blocks[block_address] = clock + cycles;
+}
 
-    std::unique_ptr<LRUSet>& cache_set = cache[set_index];
+std::tuple<int, bool, CacheState, CacheState> Memory::load_from_cache(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus) {
+    LRUSet* cache_set = cache.get(set_index);
     CacheState prev_state, curr_state;
     BusResponse response;
     std::tie(prev_state, response, curr_state) = cache_set->read(tag, bus, address, core_index);
@@ -46,119 +501,259 @@ std::tuple<int, bool, CacheState, CacheState> Memory::load(uint32_t address, Bus
     // MESI
     if (prev_state == Modified || prev_state == Exclusive || prev_state == Shared) {
         // cache hit -> load from cache
-        return {Config::CACHE_HIT_TIME, true, prev_state, curr_state};
+        return {latencies.cache_hit, true, prev_state, curr_state};
     } else if (prev_state == Invalid) {
         // cache has been invalidated -> load from memory
         if (response == BusResponseShared) {
-            return {Config::SEND_WORD_TIME + Config::CACHE_HIT_TIME, false, prev_state, curr_state};
+            return {transfer_time(address, bus) + latencies.cache_hit, false, prev_state, curr_state};
         } else if (response == BusResponseDirty) {
-            return {Config::SEND_WORD_TIME + Config::MEM_FLUSH_TIME + Config::CACHE_HIT_TIME, false, prev_state, curr_state};
+            return {transfer_time(address, bus) + bus->memory_flush_time(address, core_index, clock) + latencies.cache_hit, false, prev_state, curr_state};
         } else {
-            return {Config::MEM_FETCH_TIME + Config::CACHE_HIT_TIME, false, prev_state, curr_state};
+            return {bus->memory_fetch_time(address, core_index, clock) + latencies.cache_hit, false, prev_state, curr_state};
         }
     }
 
     // Dragon
     if (prev_state == ExclusiveDragon || prev_state == SharedClean || prev_state == SharedModified || prev_state == Dirty) {
         // cache hit -> load from cache
-        return {Config::CACHE_HIT_TIME, true, prev_state, curr_state};
+        return {latencies.cache_hit, true, prev_state, curr_state};
     }
 
-    // Not present in cache -> allocate
-    bool is_evicted;
-    std::tie(is_evicted, response) = cache_set->allocate(tag, false, bus, address, core_index);
-    curr_state = cache_set->get_state(tag);
+    // Not present in cache -> look in the victim cache, then allocate
+    int victim_cycles;
+    if (victim_cache != nullptr && swap_in_victim(address, bus, victim_cycles)) {
+        auto result = load_from_cache(address, set_index, tag, bus);
+        std::get<0>(result) += victim_cycles;
+        return result;
+    }
+
+    int write_back_cycles;
+    std::tie(write_back_cycles, response, std::ignore) = allocate_line(set_index, tag, false, address, bus);
+    curr_state = cache_set->get_state(tag, address);
     int cycles = 0;
 
     if (protocol == MESI) {
         if (response == BusResponseShared) {
-            cycles = Config::SEND_WORD_TIME + Config::CACHE_HIT_TIME;
+            cycles = transfer_time(address, bus) + latencies.cache_hit;
         } else if (response == BusResponseDirty) {
-            cycles = Config::SEND_WORD_TIME + Config::MEM_FLUSH_TIME + Config::CACHE_HIT_TIME;
+            cycles = transfer_time(address, bus) + bus->memory_flush_time(address, core_index, clock) + latencies.cache_hit;
         } else {
-            cycles = Config::MEM_FETCH_TIME + Config::CACHE_HIT_TIME;
+            cycles = bus->memory_fetch_time(address, core_index, clock) + latencies.cache_hit;
         }
     }
 
     if (protocol == Dragon) {
         if (response == BusResponseShared) {
-            cycles = Config::SEND_WORD_TIME + Config::CACHE_HIT_TIME;
+            cycles = transfer_time(address, bus) + latencies.cache_hit;
         } else if (response == BusResponseDirty) {
-            cycles = Config::SEND_WORD_TIME + Config::MEM_FLUSH_TIME + Config::CACHE_HIT_TIME;
+            cycles = transfer_time(address, bus) + bus->memory_flush_time(address, core_index, clock) + latencies.cache_hit;
         } else {
-            cycles = Config::MEM_FETCH_TIME + Config::CACHE_HIT_TIME;
+            cycles = bus->memory_fetch_time(address, core_index, clock) + latencies.cache_hit;
         }
     }
 
-    if (is_evicted) cycles += Config::MEM_FLUSH_TIME;
+    cycles += write_back_cycles;
     return {cycles, false, prev_state, curr_state};
 }
 
 std::tuple<int, bool, CacheState, CacheState> Memory::store(uint32_t address, Bus* bus) {
     uint32_t offset, set_index, tag;
     std::tie(offset, set_index, tag) = compute_tag_idx_offset(address);
+    return store(address, set_index, tag, bus);
+}
+
+std::tuple<int, bool, CacheState, CacheState> Memory::store(const DecodedInstruction& ins, Bus* bus) {
+    return store(address_of(ins.tag, ins.set_index), ins.set_index, ins.tag, bus);
+}
+
+std::tuple<int, bool, CacheState, CacheState> Memory::store(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus) {
+    if (l1_tlb != nullptr) {
+        int translation_cycles = translate(address, bus);
+        auto result = store_translated(address, set_index, tag, bus);
+        std::get<0>(result) += translation_cycles;
+        return result;
+    }
+    return store_translated(address, set_index, tag, bus);
+}
+
+std::tuple<int, bool, CacheState, CacheState> Memory::store_translated(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus) {
+    if (store_buffer != nullptr) {
+        auto result = buffer_store(address, bus);
+        clock += std::get<0>(result);
+        return result;
+    }
 
-    std::unique_ptr<LRUSet>& cache_set = cache[set_index];
+    // stores without a store buffer are blocking: wait for an outstanding fill of the block first
+    int stall = 0;
+    if (mshrs != nullptr) {
+        mshrs->retire(clock);
+        const MSHRFile::Entry* pending = mshrs->find(address & ~offset_mask);
+        if (pending != nullptr) stall = static_cast<int>(pending->ready - clock);
+    }
+
+    auto result = store_to_cache(address, set_index, tag, bus);
+    if (prefetcher != nullptr) std::get<0>(result) += use_prefetched(address & ~offset_mask, std::get<1>(result), clock + stall);
+    std::get<0>(result) += stall;
+    clock += std::get<0>(result);
+    return result;
+}
+
+std::tuple<int, bool, CacheState, CacheState> Memory::store_to_cache(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus,
+                                                                     bool exclusive, BusResponse* bus_response) {
+    LRUSet* cache_set = cache.get(set_index);
     CacheState prev_state, curr_state;
     BusResponse response;
     std::tie(prev_state, response, curr_state) = cache_set->write(tag, bus, address, core_index);
+    if (bus_response != nullptr) *bus_response = response;
 
     // MESI
     if (prev_state == Modified || prev_state == Exclusive || prev_state == Shared) {
         // cache hit -> write to cache
-        return {Config::CACHE_HIT_TIME, true, prev_state, curr_state};
+        return {latencies.cache_hit, true, prev_state, curr_state};
     } else if (prev_state == Invalid) {
         if (response == BusResponseShared) {
-            return {Config::SEND_WORD_TIME + Config::CACHE_HIT_TIME, false, prev_state, curr_state};
+            return {transfer_time(address, bus) + latencies.cache_hit, false, prev_state, curr_state};
         } else if (response == BusResponseDirty) {
-            return {Config::SEND_WORD_TIME + Config::MEM_FLUSH_TIME + Config::CACHE_HIT_TIME, false, prev_state, curr_state};
+            return {transfer_time(address, bus) + bus->memory_flush_time(address, core_index, clock) + latencies.cache_hit, false, prev_state, curr_state};
         } else {
-            return {Config::MEM_FETCH_TIME + Config::CACHE_HIT_TIME, false, prev_state, curr_state};
+            return {bus->memory_fetch_time(address, core_index, clock) + latencies.cache_hit, false, prev_state, curr_state};
         }
     }
 
     // Dragon
     if (prev_state == ExclusiveDragon || prev_state == Dirty) {
         // cache hit -> load from cache
-        return {Config::CACHE_HIT_TIME, true, prev_state, curr_state};
+        return {latencies.cache_hit, true, prev_state, curr_state};
     } else if (prev_state == SharedClean || prev_state == SharedModified) {
         // cache hit -> send update to other caches + load from cache
-        return {Config::SEND_WORD_TIME + Config::CACHE_HIT_TIME, true, prev_state, curr_state};
+        return {transfer_time(address, bus) + latencies.cache_hit, true, prev_state, curr_state};
     }
 
-    // cache miss -> allocate
-    bool is_evicted;
-    std::tie(is_evicted, response) = cache_set->allocate(tag, false, bus, address, core_index);
-    curr_state = cache_set->get_state(tag);
+    // cache miss -> look in the victim cache, then allocate
+    int victim_cycles;
+    if (victim_cache != nullptr && swap_in_victim(address, bus, victim_cycles)) {
+        auto result = store_to_cache(address, set_index, tag, bus, exclusive, bus_response);
+        std::get<0>(result) += victim_cycles;
+        return result;
+    }
+
+    int write_back_cycles;
+    std::tie(write_back_cycles, response, std::ignore) = allocate_line(set_index, tag, exclusive, address, bus);
+    if (bus_response != nullptr) *bus_response = response;
+    curr_state = cache_set->get_state(tag, address);
     int cycles = 0;
 
     if (protocol == MESI) {
         if (response == BusResponseShared) {
-            cycles = Config::SEND_WORD_TIME + Config::CACHE_HIT_TIME;
+            cycles = transfer_time(address, bus) + latencies.cache_hit;
         } else if (response == BusResponseDirty) {
-            cycles = Config::SEND_WORD_TIME + Config::MEM_FLUSH_TIME + Config::CACHE_HIT_TIME;
+            cycles = transfer_time(address, bus) + bus->memory_flush_time(address, core_index, clock) + latencies.cache_hit;
         } else {
-            cycles = Config::MEM_FETCH_TIME + Config::CACHE_HIT_TIME;
+            cycles = bus->memory_fetch_time(address, core_index, clock) + latencies.cache_hit;
         }
     }
 
     if (protocol == Dragon) {
         if (response == BusResponseShared) {
-            cycles = 2 * Config::SEND_WORD_TIME + Config::CACHE_HIT_TIME;
+            cycles = 2 * transfer_time(address, bus) + latencies.cache_hit;
         } else if (response == BusResponseDirty) {
-            cycles = 2 * Config::SEND_WORD_TIME + Config::MEM_FLUSH_TIME + Config::CACHE_HIT_TIME;
+            cycles = 2 * transfer_time(address, bus) + bus->memory_flush_time(address, core_index, clock) + latencies.cache_hit;
         } else {
-            cycles = Config::MEM_FETCH_TIME + Config::CACHE_HIT_TIME;
+            cycles = bus->memory_fetch_time(address, core_index, clock) + latencies.cache_hit;
         }
     }
 
-    if (is_evicted) cycles += Config::MEM_FLUSH_TIME;
+    cycles += write_back_cycles;
     return {cycles, false, prev_state, curr_state};
 }
 
+std::tuple<int, bool, CacheState, CacheState> Memory::atomic(uint32_t address, Bus* bus) {
+    uint32_t offset, set_index, tag;
+    std::tie(offset, set_index, tag) = compute_tag_idx_offset(address);
+    return atomic(address, set_index, tag, bus);
+}
+
+std::tuple<int, bool, CacheState, CacheState> Memory::atomic(const DecodedInstruction& ins, Bus* bus) {
+    return atomic(address_of(ins.tag, ins.set_index), ins.set_index, ins.tag, bus);
+}
+
+std::tuple<int, bool, CacheState, CacheState> Memory::atomic(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus) {
+    int cycles = l1_tlb != nullptr ? translate(address, bus) : 0;
+
+    // like a locked instruction, an atomic waits for all earlier stores and misses to complete
+    cycles += fence(bus);
+
+    // read and write the block under a single ownership request; the write after the read costs one more hit
+    BusResponse response = NoResponse;
+    auto result = store_to_cache(address, set_index, tag, bus, true, &response);
+    if (prefetcher != nullptr) std::get<0>(result) += use_prefetched(address & ~offset_mask, std::get<1>(result), clock);
+    std::get<0>(result) += latencies.cache_hit;
+    clock += std::get<0>(result);
+    std::get<0>(result) += cycles;
+
+    atomic_stats.atomics++;
+    if (response == BusResponseShared || response == BusResponseDirty) atomic_stats.contended++;
+    atomic_stats.cycles += std::get<0>(result);
+    atomic_stats.max_cycles = std::max(atomic_stats.max_cycles, static_cast<long long>(std::get<0>(result)));
+    return result;
+}
+
+void Memory::warm(uint32_t address, InstructionType type, Bus* bus) {
+    uint32_t offset, set_index, tag;
+    std::tie(offset, set_index, tag) = compute_tag_idx_offset(address);
+    warm(address, set_index, tag, type, bus);
+}
+
+void Memory::warm(const DecodedInstruction& ins, Bus* bus) {
+    warm(address_of(ins.tag, ins.set_index), ins.set_index, ins.tag, ins.type, bus);
+}
+
+void Memory::warm(uint32_t address, uint32_t set_index, uint32_t tag, InstructionType type, Bus* bus) {
+    LRUSet* cache_set = cache.get(set_index);
+
+    // a line is in either the main cache or the victim cache, never both: the main cache takes it back in the
+    // state it was saved in, like swap_in_victim but untimed, and the line it displaces is written back
+    if (victim_cache != nullptr) {
+        CacheState saved_state = victim_cache->remove(address & ~offset_mask);
+        if (saved_state != NotPresent && saved_state != Invalid) {
+            LRUSet::Line displaced{};
+            std::tie(displaced.tag, displaced.states[0]) = cache_set->insert(tag, saved_state);
+            write_back(displaced, set_index, bus, false);
+        }
+    }
+
+    CacheState prev_state = type == LOAD ? std::get<0>(cache_set->read(tag, bus, address, core_index))
+                                         : std::get<0>(cache_set->write(tag, bus, address, core_index));
+    // an atomic takes ownership of a missing line directly, like store_to_cache does for it
+    if (prev_state == NotPresent) {
+        LRUSet::Line evicted;
+        cache_set->allocate(tag, type == ATOMIC, bus, address, core_index, evicted);
+        write_back(evicted, set_index, bus, false);
+    }
+}
+
+void Memory::set_profiling(bool enabled) {
+    profiling = enabled;
+}
+
+bool Memory::is_profiling() const {
+    return profiling;
+}
+
+int Memory::memory_fence(Bus* bus) {
+    int stall = fence(bus);
+    atomic_stats.fences++;
+    atomic_stats.fence_cycles += stall;
+    return stall;
+}
+
+const AtomicStats& Memory::get_atomic_stats() const {
+    return atomic_stats;
+}
+
 std::tuple<uint32_t, uint32_t, uint32_t> Memory::compute_tag_idx_offset(uint32_t address) const {
     uint32_t offset = address & offset_mask;
-    uint32_t set_index = address & set_index_mask >> offset_bits;
-    uint32_t tag = address & tag_mask >> (offset_bits + set_index_bits);
+    uint32_t set_index = (address & set_index_mask) >> offset_bits;
+    uint32_t tag = (address & tag_mask) >> (offset_bits + set_index_bits);
     return std::make_tuple(offset, set_index, tag);
 }
\ No newline at end of file
@@ -3,9 +3,20 @@
 
 #include <vector>
 #include <iostream>
+#include <memory>
+#include <unordered_map>
 
 #include "bus.h"
 #include "cache.h"
+#include "set_table.h"
+#include "prefetcher.h"
+#include "store_buffer.h"
+#include "mshr.h"
+#include "victim_cache.h"
+#include "tlb.h"
+#include "decoded_trace.h"
+#include "sim_config.h"
+#include "stats.h"
 
 class Bus;
 
@@ -13,12 +24,75 @@ class Memory {
 public:
     // load from address: returns {number of cycles, whether it's a cache hit, previous cache state, current cache state}
     std::tuple<int, bool, CacheState, CacheState> load(uint32_t address, Bus* bus);
+    // load a pre-decoded instruction, skipping the address decomposition
+    std::tuple<int, bool, CacheState, CacheState> load(const DecodedInstruction& ins, Bus* bus);
     // store to address: returns {number of cycles, whether it's a cache hit, previous cache state, current cache state}
     std::tuple<int, bool, CacheState, CacheState> store(uint32_t address, Bus* bus);
-    // compute the {tag, set index, offset}
+    // store a pre-decoded instruction, skipping the address decomposition
+    std::tuple<int, bool, CacheState, CacheState> store(const DecodedInstruction& ins, Bus* bus);
+    // atomic read-modify-write of address: drains pending stores and misses, then takes exclusive ownership
+    // of the block in a single bus transaction; returns {number of cycles, whether it's a cache hit,
+    // previous cache state, current cache state}
+    std::tuple<int, bool, CacheState, CacheState> atomic(uint32_t address, Bus* bus);
+    std::tuple<int, bool, CacheState, CacheState> atomic(const DecodedInstruction& ins, Bus* bus);
+    // fast mode access: update the cache and coherence state of the block as a load, store or atomic would,
+    // without latencies, the clock or any of the optional features
+    void warm(uint32_t address, InstructionType type, Bus* bus);
+    void warm(const DecodedInstruction& ins, Bus* bus);
+    // whether the bus transactions of this core are counted in the bus stats
+    void set_profiling(bool enabled);
+    [[nodiscard]] bool is_profiling() const;
+    // fence instruction: returns the stall cycles
+    int memory_fence(Bus* bus);
+    [[nodiscard]] const AtomicStats& get_atomic_stats() const;
+    // compute the {offset, set index, tag}; unlike the predecode kernel this is not specialized per geometry, as
+    // one address per access costs far less than the set lookup that follows
     [[nodiscard]] std::tuple<uint32_t, uint32_t, uint32_t> compute_tag_idx_offset(uint32_t address) const;
-    // process bus signal sent from another processor
-    BusResponse process_signal_from_bus(BusMessage message, uint32_t address, Bus* bus);
+    // state of the block holding address, NotPresent if this cache holds none; the LRU order is left as it is
+    [[nodiscard]] CacheState get_block_state(uint32_t address) const;
+    // process bus signal sent from another processor, with the address already decomposed by the bus
+    BusResponse process_signal_from_bus(BusMessage message, uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus);
+    [[nodiscard]] int get_offset_bits() const;
+    [[nodiscard]] int get_set_index_bits() const;
+    // replace the compiled-in latencies of the cache
+    void set_latencies(const Latencies& _latencies);
+    // advance the core's clock by cycles spent outside the memory system:
+    // returns the stall cycles spent waiting for outstanding misses
+    int advance_clock(int cycles);
+    // attach a hardware prefetcher to the load path (nullptr disables prefetching)
+    void set_prefetcher(std::unique_ptr<Prefetcher> _prefetcher);
+    [[nodiscard]] bool has_prefetcher() const;
+    [[nodiscard]] const PrefetchStats& get_prefetch_stats() const;
+    // retire stores into a store buffer of the given number of entries (0 disables buffering)
+    void set_store_buffer_size(int entries);
+    [[nodiscard]] bool has_store_buffer() const;
+    [[nodiscard]] const StoreBufferStats& get_store_buffer_stats() const;
+    // make loads non-blocking with count miss status holding registers (0 keeps the cache blocking);
+    // the core can run overlap_window cycles past an outstanding miss before it waits for the block
+    void set_mshrs(int count, int overlap_window);
+    [[nodiscard]] bool has_mshrs() const;
+    [[nodiscard]] const MSHRStats& get_mshr_stats() const;
+    [[nodiscard]] long get_num_sets() const;
+    [[nodiscard]] int get_cache_size() const;
+    [[nodiscard]] int get_associativity() const;
+    [[nodiscard]] const Latencies& get_latencies() const;
+    // number of sets touched so far: set storage is only allocated for these
+    [[nodiscard]] long get_num_allocated_sets() const;
+    // split every line into sectors, each with its own valid and coherence state (1 keeps lines whole);
+    // must be set before the first access
+    void set_sectors(int sectors);
+    // keep lines evicted from the main cache in a victim cache of the given number of entries (0 disables it)
+    void set_victim_cache_size(int entries);
+    [[nodiscard]] bool has_victim_cache() const;
+    [[nodiscard]] const VictimCacheStats& get_victim_cache_stats() const;
+    // translate addresses through per-core L1 / L2 TLBs of the given sizes, walking the page table on misses
+    // (page_size must be a power of two; 0 entries disables translation)
+    void set_tlb(int l1_entries, int l2_entries, int page_size);
+    [[nodiscard]] bool has_tlb() const;
+    [[nodiscard]] const TLBStats& get_tlb_stats() const;
+    // wait until all buffered stores are written to the cache and all outstanding misses complete:
+    // returns the number of stall cycles
+    int fence(Bus* bus);
 
     Memory(int _index, int cache_size, int associativity, int block_size, int address_bits, Protocol _protocol);
 private:
@@ -28,6 +102,8 @@ private:
     int cache_size;
     int associativity;
     int block_size;
+    // bytes moved by one transfer: the block, or one of its sectors
+    int sector_size;
 
     int offset_bits;
     int set_index_bits;
@@ -36,8 +112,91 @@ private:
     uint32_t set_index_mask;
     uint32_t tag_mask;
 
-    // LRU sets indexed by set index
-    std::vector<std::unique_ptr<LRUSet>> cache;
+    Latencies latencies;
+
+    long num_sets;
+    // LRU sets indexed by set index, allocated on first touch
+    SetTable cache;
+
+    // cycles elapsed on this core
+    long long clock;
+
+    std::unique_ptr<Prefetcher> prefetcher;
+    // prefetched blocks not yet used by a demand load -> cycle at which the block arrives
+    std::unordered_map<uint32_t, long long> prefetched_blocks;
+    std::vector<uint32_t> prefetch_candidates;
+    PrefetchStats prefetch_stats;
+
+    std::unique_ptr<StoreBuffer> store_buffer;
+    // cycle at which the store buffer finishes writing its last drained entry
+    long long drain_clock;
+    StoreBufferStats store_buffer_stats;
+
+    std::unique_ptr<MSHRFile> mshrs;
+    MSHRStats mshr_stats;
+
+    std::unique_ptr<VictimCache> victim_cache;
+    VictimCacheStats victim_cache_stats;
+
+    std::unique_ptr<TLB> l1_tlb;
+    std::unique_ptr<TLB> l2_tlb;
+    int page_bits;
+    // levels of the page table, and the offset of each level's entries in the page table region
+    int page_table_levels;
+    std::vector<uint32_t> page_table_level_offsets;
+    TLBStats tlb_stats;
+
+    AtomicStats atomic_stats;
+    bool profiling;
+
+    std::tuple<int, bool, CacheState, CacheState> load(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus);
+    std::tuple<int, bool, CacheState, CacheState> store(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus);
+    // load / store once the address is translated
+    std::tuple<int, bool, CacheState, CacheState> load_translated(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus);
+    std::tuple<int, bool, CacheState, CacheState> store_translated(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus);
+    std::tuple<int, bool, CacheState, CacheState> load_from_cache(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus);
+    std::tuple<int, bool, CacheState, CacheState> atomic(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus);
+    void warm(uint32_t address, uint32_t set_index, uint32_t tag, InstructionType type, Bus* bus);
+    // write to the cache; an exclusive write allocates a missing line with ownership instead of reading it
+    // first, and response receives the bus response of the transaction if any
+    std::tuple<int, bool, CacheState, CacheState> store_to_cache(uint32_t address, uint32_t set_index, uint32_t tag, Bus* bus,
+                                                                 bool exclusive = false, BusResponse* response = nullptr);
+    // bring a block into the cache ahead of demand through the normal allocation path
+    void issue_prefetch(uint32_t block_address, Bus* bus);
+    // account a demand access at cycle to a block the prefetcher may have brought in: returns the cycles
+    // the access waits for the rest of a prefetch fill still in flight
+    int use_prefetched(uint32_t block_address, bool is_hit, long long cycle);
+    // retire a store into the store buffer instead of stalling for the cache
+    std::tuple<int, bool, CacheState, CacheState> buffer_store(uint32_t address, Bus* bus);
+    // write the oldest buffered store into the cache
+    void drain_one(Bus* bus);
+    // write back buffered stores the drain engine would have started by cycle
+    void drain_store_buffer(long long cycle, Bus* bus);
+    // state of the block holding address, without touching LRU order or coherence
+    CacheState peek_state(uint32_t address);
+    // block address of the line with tag in set_index
+    [[nodiscard]] uint32_t address_of(uint32_t tag, uint32_t set_index) const;
+    // cycles to move the block holding address between this cache and the one that answered its last bus
+    // request: a word time, plus the network between them on a mesh
+    int transfer_time(uint32_t address, Bus* bus) const;
+    // allocate a line in the set, moving the evicted line to the victim cache if there is one:
+    // returns {cycles spent writing back dirty data, bus response, bytes written back}
+    std::tuple<int, BusResponse, int> allocate_line(uint32_t set_index, uint32_t tag, bool is_write, uint32_t address,
+                                                    Bus* bus);
+    // write the dirty sectors of a line evicted from set_index back to memory: returns {cycles spent, sectors
+    // written}, with 0 cycles and without touching main memory's timing model if the write back is not timed
+    std::pair<int, int> write_back(const LRUSet::Line& line, uint32_t set_index, Bus* bus, bool timed = true);
+    // put a line evicted from set_index in the victim cache: returns {cycles spent writing back the dirty line it
+    // pushes out, lines written back}
+    std::pair<int, int> evict_to_victim_cache(uint32_t tag, uint32_t set_index, CacheState state, Bus* bus);
+    // move the block holding address from the victim cache back into the main cache:
+    // returns true on a victim cache hit and sets cycles to the cost of the swap
+    bool swap_in_victim(uint32_t address, Bus* bus, int& cycles);
+    // translate the virtual address of an access through the TLBs, walking the page table on a miss:
+    // returns the cycles spent
+    int translate(uint32_t address, Bus* bus);
+    // stall until the core is back inside the overlap window of its outstanding misses
+    int wait_for_window();
 };
 
 #endif
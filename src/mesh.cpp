@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "mesh.h"
+
+MeshInterconnect::MeshInterconnect(int _width, int _height, int _hop_time, int _link_width, int _block_size,
+                                   int slice_size, int _slice_associativity, int _llc_hit_time) :
+        width(_width), height(_height), hop_time(_hop_time), link_width(_link_width), block_size(_block_size),
+        slice_sets(slice_size / (_block_size * _slice_associativity)), slice_associativity(_slice_associativity),
+        llc_hit_time(_llc_hit_time) {
+    const int tiles = width * height;
+    slices.resize(static_cast<size_t>(tiles) * slice_sets);
+    link_ready.assign(tiles * 4, 0);
+    stats.width = width;
+    stats.height = height;
+    stats.link_busy_cycles.assign(tiles * 4, 0);
+}
+
+int MeshInterconnect::get_tile(int core) const {
+    return core % (width * height);
+}
+
+int MeshInterconnect::get_home(uint32_t block_address) const {
+    return static_cast<int>((block_address / block_size) % (width * height));
+}
+
+int MeshInterconnect::get_hops(int from_tile, int to_tile) const {
+    return std::abs(from_tile % width - to_tile % width) + std::abs(from_tile / width - to_tile / width);
+}
+
+int MeshInterconnect::send(int from_tile, int to_tile, int bytes, long long cycle) {
+    if (from_tile == to_tile) return 0;
+    std::lock_guard<std::mutex> lock(mtx);
+    const int flits = std::max(1, (bytes + link_width - 1) / link_width);
+
+    // XY routing: along the row to the destination column, then along the column
+    long long t = cycle;
+    int tile = from_tile;
+    while (tile != to_tile) {
+        Direction direction;
+        int next;
+        if (tile % width != to_tile % width) {
+            direction = tile % width < to_tile % width ? East : West;
+            next = direction == East ? tile + 1 : tile - 1;
+        } else {
+            direction = tile / width < to_tile / width ? South : North;
+            next = direction == South ? tile + width : tile - width;
+        }
+
+        // cores run on loosely synchronised clocks: a link busy more than a message past this one's clock
+        // is busy with another core's future, so it only delays messages close to it in time
+        const int link = tile * 4 + direction;
+        long long start = link_ready[link] - t > flits ? t : std::max(t, link_ready[link]);
+        stats.contention_cycles += start - t;
+        link_ready[link] = std::max(link_ready[link], start + flits);
+        stats.link_busy_cycles[link] += flits;
+        stats.hops++;
+
+        t = start + hop_time;
+        tile = next;
+    }
+    stats.messages++;
+
+    // the head flit pays the hops, the rest of the message follows it one flit per cycle
+    return static_cast<int>(t - cycle) + flits - 1;
+}
+
+bool MeshInterconnect::access_llc(uint32_t block_address) {
+    if (slice_sets == 0) return false;
+    std::lock_guard<std::mutex> lock(mtx);
+    const uint32_t block = block_address / block_size;
+    const int tiles = width * height;
+    SliceSet& set = slices[static_cast<size_t>(block % tiles) * slice_sets + (block / tiles) % slice_sets];
+
+    auto it = std::find(set.begin(), set.end(), block_address);
+    if (it != set.end()) {
+        std::rotate(set.begin(), it, it + 1);
+        stats.llc_hits++;
+        return true;
+    }
+    if (static_cast<int>(set.size()) == slice_associativity) set.pop_back();
+    set.insert(set.begin(), block_address);
+    stats.llc_misses++;
+    return false;
+}
+
+bool MeshInterconnect::has_llc() const {
+    return slice_sets > 0;
+}
+
+int MeshInterconnect::get_llc_hit_time() const {
+    return llc_hit_time;
+}
+
+MeshStats MeshInterconnect::get_stats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return stats;
+}
@@ -0,0 +1,71 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct MeshStats {
+    int width = 0;
+    int height = 0;
+    long messages = 0;
+    long long hops = 0;
+    // cycles spent waiting for busy links
+    long long contention_cycles = 0;
+    // per directed link, indexed by tile * 4 + direction (east, west, south, north): cycles it carried flits
+    std::vector<long long> link_busy_cycles;
+    long llc_hits = 0;
+    long llc_misses = 0;
+
+    // directed links between neighbouring tiles
+    [[nodiscard]] int get_num_links() const {
+        return 2 * (width - 1) * height + 2 * width * (height - 1);
+    }
+};
+
+// 2D mesh of tiles, one core and one slice of a shared last-level cache on each. Blocks are interleaved over
+// the slices by block address, so every block has a home tile; messages take XY routes, each hop costing a
+// fixed latency plus the wait for the link, which carries one flit per cycle
+class MeshInterconnect {
+public:
+    enum Direction { East, West, South, North };
+
+    [[nodiscard]] int get_tile(int core) const;
+    // tile whose slice holds the block
+    [[nodiscard]] int get_home(uint32_t block_address) const;
+    [[nodiscard]] int get_hops(int from_tile, int to_tile) const;
+    // send a message of the given bytes from one tile to another at cycle: returns the cycles until it arrives
+    int send(int from_tile, int to_tile, int bytes, long long cycle);
+    // look up a block in its home slice, allocating it on a miss: returns whether it was there
+    // (always false if the slices have no capacity)
+    bool access_llc(uint32_t block_address);
+    [[nodiscard]] bool has_llc() const;
+    [[nodiscard]] int get_llc_hit_time() const;
+    [[nodiscard]] MeshStats get_stats() const;
+
+    // slice_size bytes of LLC per tile (0 for no LLC); link_width bytes per flit
+    MeshInterconnect(int _width, int _height, int _hop_time, int _link_width, int _block_size,
+                     int slice_size, int slice_associativity, int _llc_hit_time);
+private:
+    // a slice set: block addresses, most recently used first
+    using SliceSet = std::vector<uint32_t>;
+
+    mutable std::mutex mtx;
+    int width;
+    int height;
+    int hop_time;
+    int link_width;
+    int block_size;
+
+    int slice_sets;
+    int slice_associativity;
+    int llc_hit_time;
+    // indexed by tile * slice_sets + set
+    std::vector<SliceSet> slices;
+
+    // cycle at which each directed link is free
+    std::vector<long long> link_ready;
+    MeshStats stats;
+};
+
+#endif //MESH_H
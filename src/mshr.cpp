@@ -0,0 +1,64 @@
+#include <algorithm>
+
+#include "mshr.h"
+
+MSHRFile::MSHRFile(int _count, int _window) : count(_count), window(_window) {}
+
+const MSHRFile::Entry* MSHRFile::find(uint32_t block_address) const {
+    for (const Entry& entry : entries) {
+        if (entry.block_address == block_address) return &entry;
+    }
+    return nullptr;
+}
+
+bool MSHRFile::is_full() const {
+    return entries.size() >= static_cast<size_t>(count);
+}
+
+int MSHRFile::size() const {
+    return static_cast<int>(entries.size());
+}
+
+void MSHRFile::allocate(uint32_t block_address, long long issue, long long ready) {
+    entries.push_back(Entry{block_address, issue, ready});
+}
+
+void MSHRFile::retire(long long cycle) {
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+        [cycle](const Entry& entry) { return entry.ready <= cycle; }), entries.end());
+}
+
+long long MSHRFile::pop_earliest() {
+    auto earliest = std::min_element(entries.begin(), entries.end(),
+        [](const Entry& a, const Entry& b) { return a.ready < b.ready; });
+    long long ready = earliest->ready;
+    entries.erase(earliest);
+    return ready;
+}
+
+long long MSHRFile::last_ready() const {
+    long long ready = 0;
+    for (const Entry& entry : entries) ready = std::max(ready, entry.ready);
+    return ready;
+}
+
+long long MSHRFile::window_stall(long long cycle) {
+    long long stall = 0;
+    while (!entries.empty()) {
+        const Entry& oldest = entries.front();
+        if (oldest.ready <= cycle + stall) {
+            entries.pop_front();
+            continue;
+        }
+        if (cycle + stall <= oldest.issue + window) break;
+
+        // the core blocked when it got a full window past the miss, and resumed when the block arrived
+        stall += oldest.ready - (oldest.issue + window);
+        entries.pop_front();
+    }
+    return stall;
+}
+
+void MSHRFile::clear() {
+    entries.clear();
+}
@@ -0,0 +1,56 @@
+#ifndef MSHR_H
+#define MSHR_H
+
+#include <cstdint>
+#include <deque>
+
+struct MSHRStats {
+    // misses that allocated a register
+    long primary_misses = 0;
+    // misses merged into a register already tracking their block
+    long secondary_misses = 0;
+    // outstanding misses summed over every primary miss, for the average occupancy
+    long long occupancy_sum = 0;
+    int max_occupancy = 0;
+    // misses that found every register busy, and the cycles they waited for one
+    long full_stalls = 0;
+    long long full_stall_cycles = 0;
+    // cycles the core waited because it ran a full window ahead of an outstanding miss
+    long long window_stall_cycles = 0;
+};
+
+// miss status holding registers: tracks the misses a non-blocking cache has outstanding
+class MSHRFile {
+public:
+    struct Entry {
+        uint32_t block_address;
+        // cycle at which the miss was sent, and at which its block arrives
+        long long issue;
+        long long ready;
+    };
+
+    // returns the register tracking the block, or nullptr if there is none
+    [[nodiscard]] const Entry* find(uint32_t block_address) const;
+    [[nodiscard]] bool is_full() const;
+    [[nodiscard]] int size() const;
+    void allocate(uint32_t block_address, long long issue, long long ready);
+    // free registers whose block has arrived by cycle
+    void retire(long long cycle);
+    // free the register that completes first: returns the cycle it completes
+    long long pop_earliest();
+    // cycle at which every outstanding miss has completed
+    [[nodiscard]] long long last_ready() const;
+    // returns the stall cycles needed so that the core at cycle is never more than the overlap
+    // window ahead of an outstanding miss, freeing registers the core waited for
+    long long window_stall(long long cycle);
+    void clear();
+
+    MSHRFile(int _count, int _window);
+private:
+    int count;
+    int window;
+    // outstanding misses in issue order
+    std::deque<Entry> entries;
+};
+
+#endif //MSHR_H
@@ -0,0 +1,130 @@
+#include <string>
+
+#include "prefetcher.h"
+#include "config.h"
+
+// block addresses past the end of the address space are not prefetched
+static bool push_candidate(int64_t address, std::vector<uint32_t>& candidates) {
+    if (address < 0 || address > UINT32_MAX) return false;
+    candidates.push_back(static_cast<uint32_t>(address));
+    return true;
+}
+
+std::string Prefetcher::get_prefetcher_str(PrefetcherType type) {
+    switch (type) {
+    case NextLine:
+        return "next-line";
+    case Stride:
+        return "stride";
+    case StreamBuffer:
+        return "stream";
+    case NoPrefetcher:
+        return "none";
+    default:
+        return "";
+    }
+}
+
+std::unique_ptr<Prefetcher> Prefetcher::create(PrefetcherType type, int block_size) {
+    switch (type) {
+    case NextLine:
+        return std::make_unique<NextLinePrefetcher>(block_size);
+    case Stride:
+        return std::make_unique<StridePrefetcher>(block_size);
+    case StreamBuffer:
+        return std::make_unique<StreamBufferPrefetcher>(block_size);
+    case NoPrefetcher:
+    default:
+        return nullptr;
+    }
+}
+
+NextLinePrefetcher::NextLinePrefetcher(int _block_size) : block_size(_block_size) {}
+
+void NextLinePrefetcher::on_access(uint32_t block_address, bool is_miss, std::vector<uint32_t>& candidates) {
+    if (!is_miss) return;
+    for (int i = 1; i <= Config::PREFETCH_DEGREE; i++) {
+        if (!push_candidate(static_cast<int64_t>(block_address) + static_cast<int64_t>(i) * block_size, candidates)) break;
+    }
+}
+
+StridePrefetcher::StridePrefetcher(int _block_size) : block_size(_block_size), accesses(0),
+        table(Config::STRIDE_TABLE_SIZE, Entry{0, 0, 0, 0, 0, false}) {}
+
+// trains on hits as well as misses: a stream that hits on its prefetched blocks must keep running ahead
+void StridePrefetcher::on_access(uint32_t block_address, bool, std::vector<uint32_t>& candidates) {
+    accesses++;
+    uint32_t region = block_address >> Config::STRIDE_REGION_BITS;
+
+    // find the stream of this region, or the least recently used entry to replace
+    Entry* entry = nullptr;
+    Entry* victim = &table[0];
+    for (Entry& e : table) {
+        if (e.valid && e.region == region) {
+            entry = &e;
+            break;
+        }
+        if (!e.valid || (victim->valid && e.last_used < victim->last_used)) victim = &e;
+    }
+
+    if (entry == nullptr) {
+        // new stream: no stride known yet
+        *victim = Entry{region, block_address, 0, 0, accesses, true};
+        return;
+    }
+
+    entry->last_used = accesses;
+    int64_t stride = static_cast<int64_t>(block_address) - static_cast<int64_t>(entry->last_address);
+    if (stride == 0) return;
+
+    if (stride == entry->stride) {
+        if (entry->confidence < Config::STRIDE_CONFIDENCE_THRESHOLD + 1) entry->confidence++;
+    } else {
+        entry->stride = stride;
+        entry->confidence = 0;
+    }
+    entry->last_address = block_address;
+
+    if (entry->confidence < Config::STRIDE_CONFIDENCE_THRESHOLD) return;
+    for (int i = 1; i <= Config::PREFETCH_DEGREE; i++) {
+        if (!push_candidate(static_cast<int64_t>(block_address) + i * stride, candidates)) break;
+    }
+}
+
+StreamBufferPrefetcher::StreamBufferPrefetcher(int _block_size) : block_size(_block_size), accesses(0),
+        streams(Config::STREAM_BUFFER_COUNT, Stream{0, 0, 0, false}) {}
+
+void StreamBufferPrefetcher::on_access(uint32_t block_address, bool is_miss, std::vector<uint32_t>& candidates) {
+    accesses++;
+
+    for (Stream& s : streams) {
+        if (!s.valid || block_address < s.head || block_address > s.tail) continue;
+
+        // demand stream reached this buffer: consume up to the accessed block and refill the buffer
+        s.last_used = accesses;
+        s.head = block_address + block_size;
+        while (static_cast<int64_t>(s.tail) < static_cast<int64_t>(s.head) + static_cast<int64_t>(Config::STREAM_BUFFER_DEPTH - 1) * block_size) {
+            if (!push_candidate(static_cast<int64_t>(s.tail) + block_size, candidates)) break;
+            s.tail += block_size;
+        }
+        return;
+    }
+
+    if (!is_miss) return;
+
+    // miss outside every stream: restart the least recently used stream buffer after this block
+    Stream* victim = &streams[0];
+    for (Stream& s : streams) {
+        if (!s.valid) {
+            victim = &s;
+            break;
+        }
+        if (s.last_used < victim->last_used) victim = &s;
+    }
+
+    *victim = Stream{block_address + block_size, block_address, accesses, true};
+    for (int i = 1; i <= Config::STREAM_BUFFER_DEPTH; i++) {
+        if (!push_candidate(static_cast<int64_t>(block_address) + static_cast<int64_t>(i) * block_size, candidates)) break;
+        victim->tail += block_size;
+    }
+}
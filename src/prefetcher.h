@@ -0,0 +1,88 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "enums.h"
+
+struct PrefetchStats {
+    // prefetches sent on the bus
+    long issued = 0;
+    // prefetched blocks later hit by a demand load, store or atomic
+    long useful = 0;
+    // useful prefetches whose block had not arrived yet when the demand access came
+    long late = 0;
+    // cycles demand accesses waited on late prefetches
+    long long late_cycles = 0;
+    // demand misses that the prefetcher did not cover
+    long demand_misses = 0;
+    // bytes moved on the bus by prefetch fills and the write backs they caused
+    long long traffic = 0;
+};
+
+class Prefetcher {
+public:
+    // observe a demand load of a block and append the block addresses to prefetch to candidates
+    virtual void on_access(uint32_t block_address, bool is_miss, std::vector<uint32_t>& candidates) = 0;
+    // get string name of prefetcher for reporting
+    static std::string get_prefetcher_str(PrefetcherType type);
+    static std::unique_ptr<Prefetcher> create(PrefetcherType type, int block_size);
+
+    virtual ~Prefetcher() = default;
+};
+
+// prefetches the next PREFETCH_DEGREE blocks on every demand miss
+class NextLinePrefetcher : public Prefetcher {
+public:
+    void on_access(uint32_t block_address, bool is_miss, std::vector<uint32_t>& candidates) override;
+
+    explicit NextLinePrefetcher(int _block_size);
+private:
+    int block_size;
+};
+
+// detects constant strides in the address stream of each memory region (no PC available in traces)
+class StridePrefetcher : public Prefetcher {
+public:
+    void on_access(uint32_t block_address, bool is_miss, std::vector<uint32_t>& candidates) override;
+
+    explicit StridePrefetcher(int _block_size);
+private:
+    struct Entry {
+        uint32_t region;
+        uint32_t last_address;
+        int64_t stride;
+        int confidence;
+        long last_used;
+        bool valid;
+    };
+
+    int block_size;
+    long accesses;
+    std::vector<Entry> table;
+};
+
+// keeps STREAM_BUFFER_COUNT sequential streams running ahead of the demand stream
+class StreamBufferPrefetcher : public Prefetcher {
+public:
+    void on_access(uint32_t block_address, bool is_miss, std::vector<uint32_t>& candidates) override;
+
+    explicit StreamBufferPrefetcher(int _block_size);
+private:
+    struct Stream {
+        // next block the demand stream is expected to touch
+        uint32_t head;
+        // last block prefetched for this stream
+        uint32_t tail;
+        long last_used;
+        bool valid;
+    };
+
+    int block_size;
+    long accesses;
+    std::vector<Stream> streams;
+};
+
+#endif //PREFETCHER_H
@@ -5,6 +5,14 @@
 #include "profiler.h"
 
 #include "bus.h"
+#include "memory.h"
+#include "dram.h"
+#include "json_writer.h"
+
+void Profiler::print_percentage(const std::string& label, long long part, long long whole) {
+    int thousandth = whole == 0 ? 0 : static_cast<int>(static_cast<double>(part) / whole * 1000);
+    std::cout << label << " (%): " << thousandth / 10 << "." << thousandth % 10 << std::endl;
+}
 
 Profiler::Profiler(int num_cores) {
     this->num_cores = num_cores;
@@ -18,6 +26,7 @@ Profiler::Profiler(int num_cores) {
 
     loads_per_core = std::vector<long>(num_cores, 0);
     stores_per_core = std::vector<long>(num_cores, 0);
+    fast_forwarded_per_core = std::vector<long>(num_cores, 0);
 }
 
 void Profiler::update(InstructionType type, int j, int this_cycles, bool is_hit, CacheState from_state, CacheState to_state) {
@@ -56,6 +65,26 @@ void Profiler::update(InstructionType type, int j, int this_cycles, bool is_hit,
             }
             break;
 
+        case ATOMIC:
+            if (is_hit) {
+                cache_hits_per_core[j]++;
+            } else {
+                cache_misses_per_core[j]++;
+            }
+
+            idle_cycles_per_core[j] += this_cycles;
+
+            if (to_state == Modified || to_state == Exclusive || to_state == ExclusiveDragon || to_state == Dirty) {
+                private_accesses.fetch_add(1, std::memory_order_relaxed);
+            } else if (to_state == Shared || to_state == SharedModified || to_state == SharedClean) {
+                shared_accesses.fetch_add(1, std::memory_order_relaxed);
+            }
+            break;
+
+        case FENCE:
+            idle_cycles_per_core[j] += this_cycles;
+            break;
+
         case OTHER:
             compute_cycles_per_core[j] += this_cycles;
             break;
@@ -67,37 +96,172 @@ void Profiler::update(InstructionType type, int j, int this_cycles, bool is_hit,
     cycles_per_core[j] += this_cycles;
 }
 
-void Profiler::print_stats(Bus* bus) {
+void Profiler::add_stall_cycles(int j, int cycles) {
+    idle_cycles_per_core[j] += cycles;
+    cycles_per_core[j] += cycles;
+}
+
+void Profiler::add_fast_forwarded(int j) {
+    fast_forwarded_per_core[j]++;
+}
+
+long long Profiler::get_core_cycles(int j) const {
+    return cycles_per_core[j];
+}
+
+SimulationStats Profiler::collect(Bus* bus, const std::vector<Memory*>& memories) const {
+    SimulationStats stats;
+    stats.cores.resize(num_cores);
+    for (int j = 0; j < num_cores; j++) {
+        CoreStats& core = stats.cores[j];
+        core.cycles = cycles_per_core[j];
+        core.idle_cycles = idle_cycles_per_core[j];
+        core.compute_cycles = compute_cycles_per_core[j];
+        core.loads = loads_per_core[j];
+        core.stores = stores_per_core[j];
+        core.cache_hits = cache_hits_per_core[j];
+        core.cache_misses = cache_misses_per_core[j];
+        core.sets_allocated = memories[j]->get_num_allocated_sets();
+        core.num_sets = memories[j]->get_num_sets();
+        core.cache_size = memories[j]->get_cache_size();
+        core.associativity = memories[j]->get_associativity();
+        core.cache_hit_time = memories[j]->get_latencies().cache_hit;
+        core.fast_forwarded = fast_forwarded_per_core[j];
+        core.has_prefetcher = memories[j]->has_prefetcher();
+        core.prefetch = memories[j]->get_prefetch_stats();
+        core.has_store_buffer = memories[j]->has_store_buffer();
+        core.store_buffer = memories[j]->get_store_buffer_stats();
+        core.has_mshrs = memories[j]->has_mshrs();
+        core.mshr = memories[j]->get_mshr_stats();
+        core.has_victim_cache = memories[j]->has_victim_cache();
+        core.victim_cache = memories[j]->get_victim_cache_stats();
+        core.has_tlb = memories[j]->has_tlb();
+        core.tlb = memories[j]->get_tlb_stats();
+        core.atomic = memories[j]->get_atomic_stats();
+    }
+
+    stats.total_traffic = bus->get_total_traffic();
+    stats.total_invalidations_updates = bus->get_total_invalidations();
+    stats.private_accesses = private_accesses.load();
+    stats.shared_accesses = shared_accesses.load();
+
+    MeshInterconnect* mesh = bus->get_mesh();
+    if (mesh != nullptr) {
+        stats.has_mesh = true;
+        stats.mesh = mesh->get_stats();
+    }
+
+    MemoryController* controller = bus->get_memory_controller();
+    if (controller != nullptr) {
+        stats.has_dram = true;
+        stats.dram.page_policy = controller->get_page_policy();
+        stats.dram.num_channels = controller->get_num_channels();
+        stats.dram.num_banks = controller->get_num_banks();
+        for (int c = 0; c < stats.dram.num_channels; c++) {
+            for (int b = 0; b < stats.dram.num_banks; b++) {
+                stats.dram.banks.push_back(controller->get_bank_stats(c, b));
+            }
+        }
+    }
+    return stats;
+}
+
+void Profiler::print_stats(const SimulationStats& stats) {
+    const int num_cores = static_cast<int>(stats.cores.size());
+    if (num_cores == 0) return;
+
+    // name the cache of each core when the cores do not all share one configuration
+    bool heterogeneous = false;
+    for (const CoreStats& core : stats.cores) {
+        const CoreStats& first = stats.cores.front();
+        heterogeneous |= core.cache_size != first.cache_size || core.associativity != first.associativity
+                         || core.cache_hit_time != first.cache_hit_time;
+    }
+
     for (int j = 0; j < num_cores; j++) {
+        const CoreStats& core = stats.cores[j];
         std::cout << "[Core " << j << "]" << std::endl;
-        std::cout << "Cycles: " << cycles_per_core[j] << std::endl;
-        std::cout << "Idle cycles: " << idle_cycles_per_core[j] << std::endl;
-        std::cout << "Compute cycles: " << compute_cycles_per_core[j] << std::endl;
-        std::cout << "Loads: " << loads_per_core[j] << std::endl;
-        std::cout << "Stores: " << stores_per_core[j] << std::endl;
-        std::cout << "Cache hits: " << cache_hits_per_core[j] << std::endl;
-        std::cout << "Cache misses: " << cache_misses_per_core[j] << std::endl;
+        if (heterogeneous) {
+            std::cout << "Cache: " << core.cache_size << " bytes, " << core.associativity << "-way, hit "
+                      << core.cache_hit_time << " cycles" << std::endl;
+        }
+        std::cout << "Cycles: " << core.cycles << std::endl;
+        std::cout << "Idle cycles: " << core.idle_cycles << std::endl;
+        std::cout << "Compute cycles: " << core.compute_cycles << std::endl;
+        std::cout << "Loads: " << core.loads << std::endl;
+        std::cout << "Stores: " << core.stores << std::endl;
+        std::cout << "Cache hits: " << core.cache_hits << std::endl;
+        std::cout << "Cache misses: " << core.cache_misses << std::endl;
+        std::cout << "Cache sets allocated: " << core.sets_allocated << " of " << core.num_sets << std::endl;
+        if (core.fast_forwarded > 0) std::cout << "Fast-forwarded instructions: " << core.fast_forwarded << std::endl;
+        if (core.has_prefetcher) {
+            const PrefetchStats& pf = core.prefetch;
+            std::cout << "Prefetches issued: " << pf.issued << std::endl;
+            print_percentage("Prefetch accuracy", pf.useful, pf.issued);
+            print_percentage("Prefetch coverage", pf.useful, pf.useful + pf.demand_misses);
+            print_percentage("Late prefetches", pf.late, pf.useful);
+            std::cout << "Cycles waiting on late prefetches: " << pf.late_cycles << std::endl;
+            std::cout << "Prefetch bus traffic (bytes): " << pf.traffic << std::endl;
+        }
+        if (core.has_store_buffer) {
+            const StoreBufferStats& sb = core.store_buffer;
+            print_percentage("Store buffer coalescing rate", sb.coalesced, sb.stores);
+            std::cout << "Store-to-load forwards: " << sb.forwarded << std::endl;
+            std::cout << "Store buffer full stalls: " << sb.full_stalls
+                      << " (" << sb.full_stall_cycles << " cycles)" << std::endl;
+            std::cout << "Store buffer fence stall cycles: " << sb.fence_stall_cycles << std::endl;
+        }
+        if (core.has_mshrs) {
+            const MSHRStats& mshr = core.mshr;
+            std::cout << "MSHR primary misses: " << mshr.primary_misses << std::endl;
+            std::cout << "MSHR merged secondary misses: " << mshr.secondary_misses << std::endl;
+            std::cout << "Average MSHR occupancy: "
+                      << (mshr.primary_misses == 0 ? 0.0 : static_cast<double>(mshr.occupancy_sum) / mshr.primary_misses)
+                      << " (max " << mshr.max_occupancy << ")" << std::endl;
+            std::cout << "MSHR full stalls: " << mshr.full_stalls
+                      << " (" << mshr.full_stall_cycles << " cycles)" << std::endl;
+            std::cout << "Overlap window stall cycles: " << mshr.window_stall_cycles << std::endl;
+        }
+        if (core.has_victim_cache) {
+            const VictimCacheStats& vc = core.victim_cache;
+            std::cout << "Victim cache hits: " << vc.hits << " (" << vc.insertions << " insertions)" << std::endl;
+            std::cout << "Victim cache write backs: " << vc.write_backs << std::endl;
+            std::cout << "Victim cache cycles saved: " << vc.cycles_saved << std::endl;
+        }
+        if (core.atomic.atomics > 0 || core.atomic.fences > 0) {
+            const AtomicStats& at = core.atomic;
+            std::cout << "Atomics: " << at.atomics << std::endl;
+            print_percentage("Contended atomics", at.contended, at.atomics);
+            std::cout << "Average atomic latency: " << (at.atomics == 0 ? 0.0 : static_cast<double>(at.cycles) / at.atomics)
+                      << " (max " << at.max_cycles << ")" << std::endl;
+            std::cout << "Fences: " << at.fences << " (" << at.fence_cycles << " stall cycles)" << std::endl;
+        }
+        if (core.has_tlb) {
+            const TLBStats& tlb = core.tlb;
+            long translations = tlb.l1_hits + tlb.l2_hits + tlb.misses;
+            print_percentage("L1 TLB hit rate", tlb.l1_hits, translations);
+            print_percentage("L2 TLB hit rate", tlb.l2_hits, tlb.l2_hits + tlb.misses);
+            std::cout << "Page walks: " << tlb.misses << " (" << tlb.walk_cycles << " cycles)" << std::endl;
+            print_percentage("Page walk cache hit rate", tlb.walk_cache_hits, tlb.walk_accesses);
+            std::cout << "Translation cycles: " << tlb.cycles << std::endl;
+        }
         std::cout << std::endl;
     }
 
     std::cout << "[Global]" << std::endl;
-    long long max_cycles = cycles_per_core[0];
-    for (int j = 1; j < num_cores; j++) {
-        max_cycles = std::max(max_cycles, cycles_per_core[j]);
-    }
-    std::cout << "Overall cycles (maximum among cores): " << max_cycles << std::endl;
+    std::cout << "Overall cycles (maximum among cores): " << stats.get_overall_cycles() << std::endl;
 
     long long total_idle_cycles = 0;
-    for (int j = 0; j < num_cores; j++) {
-        total_idle_cycles += idle_cycles_per_core[j];
+    for (const CoreStats& core : stats.cores) {
+        total_idle_cycles += core.idle_cycles;
     }
     std::cout << "Total idle cycles: " << total_idle_cycles << std::endl;
 
     long total_hits = 0;
     long total_misses = 0;
-    for (int j = 0; j < num_cores; j++) {
-        total_hits += cache_hits_per_core[j];
-        total_misses += cache_misses_per_core[j];
+    for (const CoreStats& core : stats.cores) {
+        total_hits += core.cache_hits;
+        total_misses += core.cache_misses;
     }
     int hit_rate_thousandth = static_cast<float>(total_hits) / (total_hits + total_misses) * 1000;
     std::cout << "Cache hit rate (%): " << hit_rate_thousandth / 10 << "." << hit_rate_thousandth % 10
@@ -106,10 +270,316 @@ void Profiler::print_stats(Bus* bus) {
     std::cout << "Cache miss rate (%): " << miss_rate_thousandth / 10 << "." << miss_rate_thousandth % 10
               << " (" << total_misses << ")" << std::endl;
 
-    std::cout << "Total bus traffic (bytes): " << bus->get_total_traffic() << std::endl;
-    std::cout << "Total bus invalidations / updates: " << bus->get_total_invalidations() << std::endl;
-    int private_accesses_thousandth = static_cast<float>(private_accesses) / (private_accesses + shared_accesses) * 1000;
+    std::cout << "Total bus traffic (bytes): " << stats.total_traffic << std::endl;
+    std::cout << "Total bus invalidations / updates: " << stats.total_invalidations_updates << std::endl;
+    if (stats.cores[0].has_prefetcher) {
+        PrefetchStats total;
+        for (const CoreStats& core : stats.cores) {
+            const PrefetchStats& pf = core.prefetch;
+            total.issued += pf.issued;
+            total.useful += pf.useful;
+            total.late += pf.late;
+            total.demand_misses += pf.demand_misses;
+            total.traffic += pf.traffic;
+        }
+        print_percentage("Prefetch accuracy", total.useful, total.issued);
+        print_percentage("Prefetch coverage", total.useful, total.useful + total.demand_misses);
+        print_percentage("Late prefetches", total.late, total.useful);
+        std::cout << "Total prefetch bus traffic (bytes): " << total.traffic << std::endl;
+    }
+    if (stats.cores[0].has_store_buffer) {
+        StoreBufferStats total;
+        for (const CoreStats& core : stats.cores) {
+            const StoreBufferStats& sb = core.store_buffer;
+            total.stores += sb.stores;
+            total.coalesced += sb.coalesced;
+            total.full_stalls += sb.full_stalls;
+            total.full_stall_cycles += sb.full_stall_cycles;
+        }
+        print_percentage("Store buffer coalescing rate", total.coalesced, total.stores);
+        std::cout << "Total store buffer full stalls: " << total.full_stalls
+                  << " (" << total.full_stall_cycles << " cycles)" << std::endl;
+    }
+    if (stats.cores[0].has_mshrs) {
+        long long total_full_stall_cycles = 0;
+        long long total_window_stall_cycles = 0;
+        for (const CoreStats& core : stats.cores) {
+            total_full_stall_cycles += core.mshr.full_stall_cycles;
+            total_window_stall_cycles += core.mshr.window_stall_cycles;
+        }
+        std::cout << "Total MSHR full stall cycles: " << total_full_stall_cycles << std::endl;
+        std::cout << "Total overlap window stall cycles: " << total_window_stall_cycles << std::endl;
+    }
+    if (stats.cores[0].has_victim_cache) {
+        long total_victim_hits = 0;
+        long long total_cycles_saved = 0;
+        for (const CoreStats& core : stats.cores) {
+            total_victim_hits += core.victim_cache.hits;
+            total_cycles_saved += core.victim_cache.cycles_saved;
+        }
+        std::cout << "Total victim cache hits: " << total_victim_hits << std::endl;
+        std::cout << "Total victim cache cycles saved: " << total_cycles_saved << std::endl;
+    }
+    AtomicStats total_atomic;
+    for (const CoreStats& core : stats.cores) {
+        total_atomic.atomics += core.atomic.atomics;
+        total_atomic.contended += core.atomic.contended;
+        total_atomic.cycles += core.atomic.cycles;
+        total_atomic.max_cycles = std::max(total_atomic.max_cycles, core.atomic.max_cycles);
+        total_atomic.fences += core.atomic.fences;
+        total_atomic.fence_cycles += core.atomic.fence_cycles;
+    }
+    if (total_atomic.atomics > 0 || total_atomic.fences > 0) {
+        std::cout << "Total atomics: " << total_atomic.atomics << std::endl;
+        print_percentage("Contended atomics", total_atomic.contended, total_atomic.atomics);
+        std::cout << "Average atomic latency: "
+                  << (total_atomic.atomics == 0 ? 0.0 : static_cast<double>(total_atomic.cycles) / total_atomic.atomics)
+                  << " (max " << total_atomic.max_cycles << ")" << std::endl;
+        std::cout << "Total fences: " << total_atomic.fences << " (" << total_atomic.fence_cycles << " stall cycles)" << std::endl;
+    }
+    if (stats.cores[0].has_tlb) {
+        TLBStats total;
+        for (const CoreStats& core : stats.cores) {
+            total.l1_hits += core.tlb.l1_hits;
+            total.l2_hits += core.tlb.l2_hits;
+            total.misses += core.tlb.misses;
+            total.cycles += core.tlb.cycles;
+            total.walk_cycles += core.tlb.walk_cycles;
+        }
+        print_percentage("L1 TLB hit rate", total.l1_hits, total.l1_hits + total.l2_hits + total.misses);
+        print_percentage("L2 TLB hit rate", total.l2_hits, total.l2_hits + total.misses);
+        std::cout << "Total page walks: " << total.misses << " (" << total.walk_cycles << " cycles)" << std::endl;
+        std::cout << "Total translation cycles: " << total.cycles << std::endl;
+    }
+    int private_accesses_thousandth = static_cast<float>(stats.private_accesses) / (stats.private_accesses + stats.shared_accesses) * 1000;
     std::cout << "Private data access (%): " << private_accesses_thousandth / 10 << "." << private_accesses_thousandth % 10 << std::endl;
     int shared_accesses_thousandth = 1000 - private_accesses_thousandth;
     std::cout << "Shared data access (%): " << shared_accesses_thousandth / 10 << "." << shared_accesses_thousandth % 10 << std::endl;
+
+    if (stats.has_mesh) {
+        const MeshStats& mesh = stats.mesh;
+        std::cout << std::endl << "[Mesh] (" << mesh.width << "x" << mesh.height << ")" << std::endl;
+        std::cout << "Messages: " << mesh.messages << std::endl;
+        long long hops_tenths = mesh.messages == 0 ? 0 : mesh.hops * 10 / mesh.messages;
+        std::cout << "Average hops: " << hops_tenths / 10 << "." << hops_tenths % 10 << std::endl;
+        std::cout << "Link contention cycles: " << mesh.contention_cycles << std::endl;
+        long long total_busy = 0;
+        long long busiest = 0;
+        for (long long busy : mesh.link_busy_cycles) {
+            total_busy += busy;
+            busiest = std::max(busiest, busy);
+        }
+        const long long overall_cycles = stats.get_overall_cycles();
+        print_percentage("Average link utilization", total_busy, overall_cycles * mesh.get_num_links());
+        print_percentage("Busiest link utilization", busiest, overall_cycles);
+        if (mesh.llc_hits + mesh.llc_misses > 0) {
+            std::cout << "LLC hits: " << mesh.llc_hits << std::endl;
+            std::cout << "LLC misses: " << mesh.llc_misses << std::endl;
+            print_percentage("LLC hit rate", mesh.llc_hits, mesh.llc_hits + mesh.llc_misses);
+        }
+    }
+
+    if (stats.has_dram) {
+        const DRAMStats& dram = stats.dram;
+        std::cout << std::endl << "[DRAM] (" << (dram.page_policy == OpenPage ? "open" : "closed")
+                  << " page)" << std::endl;
+        long total_accesses = 0;
+        long total_row_hits = 0;
+        for (int c = 0; c < dram.num_channels; c++) {
+            for (int b = 0; b < dram.num_banks; b++) {
+                const BankStats& bank = dram.banks[c * dram.num_banks + b];
+                long accesses = bank.row_hits + bank.row_empty + bank.row_conflicts;
+                total_accesses += accesses;
+                total_row_hits += bank.row_hits;
+                std::cout << "Channel " << c << " bank " << b << ": " << bank.reads << " reads, "
+                          << bank.writes << " writes, " << bank.row_conflicts << " row conflicts" << std::endl;
+                print_percentage("Channel " + std::to_string(c) + " bank " + std::to_string(b) + " row hit rate",
+                                 bank.row_hits, accesses);
+            }
+        }
+        print_percentage("Overall row hit rate", total_row_hits, total_accesses);
+    }
+
+    if (stats.has_host_perf) {
+        std::cout << std::endl << "[Host]" << std::endl;
+        long long accesses = stats.get_simulated_accesses();
+        std::cout << "Simulated accesses: " << accesses << std::endl;
+        if (stats.host_time_ns > 0) {
+            std::cout << "Simulated accesses per second: " << static_cast<double>(accesses) * 1e9 / stats.host_time_ns << std::endl;
+        }
+        if (accesses > 0) {
+            std::cout << "Host ns per simulated access: " << static_cast<double>(stats.host_time_ns) / accesses << std::endl;
+        }
+        if (stats.host_threads.empty()) {
+            std::cout << "Host counters unavailable: " << stats.host_perf_error << std::endl;
+            return;
+        }
+
+        // a counter the host could not provide on some thread is left out of the totals
+        HostCounters total;
+        total.cycles = total.instructions = total.cache_misses = total.branch_misses = 0;
+        auto print_counter = [](const std::string& label, long long value) {
+            std::cout << label << ": ";
+            if (value < 0) std::cout << "n/a";
+            else std::cout << value;
+        };
+        auto add_counter = [](long long& sum, long long value) {
+            if (value >= 0 && sum >= 0) sum += value;
+            else sum = -1;
+        };
+        for (const HostCounters& thread : stats.host_threads) {
+            std::cout << thread.thread << ": ";
+            print_counter("cycles", thread.cycles);
+            print_counter(", instructions", thread.instructions);
+            if (thread.cycles > 0 && thread.instructions >= 0) {
+                std::cout << " (IPC " << static_cast<double>(thread.instructions) / thread.cycles << ")";
+            }
+            print_counter(", cache misses", thread.cache_misses);
+            print_counter(", branch misses", thread.branch_misses);
+            std::cout << std::endl;
+            add_counter(total.cycles, thread.cycles);
+            add_counter(total.instructions, thread.instructions);
+            add_counter(total.cache_misses, thread.cache_misses);
+            add_counter(total.branch_misses, thread.branch_misses);
+        }
+
+        if (total.cycles > 0 && total.instructions >= 0) {
+            std::cout << "Host IPC: " << static_cast<double>(total.instructions) / total.cycles << std::endl;
+        }
+        if (accesses > 0) {
+            if (total.instructions >= 0) {
+                std::cout << "Host instructions per simulated access: " << static_cast<double>(total.instructions) / accesses << std::endl;
+            }
+            if (total.cache_misses >= 0) {
+                std::cout << "Host cache misses per simulated access: " << static_cast<double>(total.cache_misses) / accesses << std::endl;
+            }
+            if (total.branch_misses >= 0) {
+                std::cout << "Host branch misses per simulated access: " << static_cast<double>(total.branch_misses) / accesses << std::endl;
+            }
+        }
+        // misses per thousand host instructions point at what the simulator itself is bound by
+        if (total.instructions > 0) {
+            if (total.cache_misses >= 0) {
+                std::cout << "Host cache MPKI: " << static_cast<double>(total.cache_misses) * 1000 / total.instructions << std::endl;
+            }
+            if (total.branch_misses >= 0) {
+                std::cout << "Host branch MPKI: " << static_cast<double>(total.branch_misses) * 1000 / total.instructions << std::endl;
+            }
+        }
+    }
+}
+
+void Profiler::write_json(const SimulationStats& stats, JsonWriter& json) {
+    json.begin_object();
+    json.member("overall_cycles", stats.get_overall_cycles());
+    json.member("total_traffic", stats.total_traffic);
+    json.member("invalidations_updates", stats.total_invalidations_updates);
+    json.member("private_accesses", stats.private_accesses);
+    json.member("shared_accesses", stats.shared_accesses);
+    json.member("host_time_ms", stats.host_time_ms);
+
+    json.key("cores").begin_array();
+    for (const CoreStats& core : stats.cores) {
+        json.begin_object();
+        json.member("cache_size", core.cache_size);
+        json.member("associativity", core.associativity);
+        json.member("cycles", core.cycles);
+        json.member("idle_cycles", core.idle_cycles);
+        json.member("compute_cycles", core.compute_cycles);
+        json.member("loads", core.loads);
+        json.member("stores", core.stores);
+        json.member("cache_hits", core.cache_hits);
+        json.member("cache_misses", core.cache_misses);
+        json.member("sets_allocated", core.sets_allocated);
+        if (core.fast_forwarded > 0) json.member("fast_forwarded", core.fast_forwarded);
+        if (core.has_prefetcher) {
+            json.key("prefetch").begin_object();
+            json.member("issued", core.prefetch.issued);
+            json.member("useful", core.prefetch.useful);
+            json.member("late", core.prefetch.late);
+            json.member("late_cycles", core.prefetch.late_cycles);
+            json.member("demand_misses", core.prefetch.demand_misses);
+            json.member("traffic", core.prefetch.traffic);
+            json.end_object();
+        }
+        if (core.has_store_buffer) {
+            json.key("store_buffer").begin_object();
+            json.member("stores", core.store_buffer.stores);
+            json.member("coalesced", core.store_buffer.coalesced);
+            json.member("forwarded", core.store_buffer.forwarded);
+            json.member("full_stalls", core.store_buffer.full_stalls);
+            json.member("full_stall_cycles", core.store_buffer.full_stall_cycles);
+            json.member("fence_stall_cycles", core.store_buffer.fence_stall_cycles);
+            json.end_object();
+        }
+        if (core.has_mshrs) {
+            json.key("mshr").begin_object();
+            json.member("primary_misses", core.mshr.primary_misses);
+            json.member("secondary_misses", core.mshr.secondary_misses);
+            json.member("max_occupancy", core.mshr.max_occupancy);
+            json.member("full_stalls", core.mshr.full_stalls);
+            json.member("full_stall_cycles", core.mshr.full_stall_cycles);
+            json.member("window_stall_cycles", core.mshr.window_stall_cycles);
+            json.end_object();
+        }
+        if (core.has_victim_cache) {
+            json.key("victim_cache").begin_object();
+            json.member("hits", core.victim_cache.hits);
+            json.member("cycles_saved", core.victim_cache.cycles_saved);
+            json.member("insertions", core.victim_cache.insertions);
+            json.member("write_backs", core.victim_cache.write_backs);
+            json.end_object();
+        }
+        if (core.has_tlb) {
+            json.key("tlb").begin_object();
+            json.member("l1_hits", core.tlb.l1_hits);
+            json.member("l2_hits", core.tlb.l2_hits);
+            json.member("misses", core.tlb.misses);
+            json.member("cycles", core.tlb.cycles);
+            json.member("walk_cycles", core.tlb.walk_cycles);
+            json.end_object();
+        }
+        if (core.atomic.atomics > 0 || core.atomic.fences > 0) {
+            json.key("atomic").begin_object();
+            json.member("atomics", core.atomic.atomics);
+            json.member("contended", core.atomic.contended);
+            json.member("cycles", core.atomic.cycles);
+            json.member("max_cycles", core.atomic.max_cycles);
+            json.member("fences", core.atomic.fences);
+            json.member("fence_cycles", core.atomic.fence_cycles);
+            json.end_object();
+        }
+        json.end_object();
+    }
+    json.end_array();
+
+    if (stats.has_mesh) {
+        json.key("mesh").begin_object();
+        json.member("width", stats.mesh.width);
+        json.member("height", stats.mesh.height);
+        json.member("messages", stats.mesh.messages);
+        json.member("hops", stats.mesh.hops);
+        json.member("contention_cycles", stats.mesh.contention_cycles);
+        json.member("llc_hits", stats.mesh.llc_hits);
+        json.member("llc_misses", stats.mesh.llc_misses);
+        json.key("link_busy_cycles").begin_array();
+        for (long long busy : stats.mesh.link_busy_cycles) json.value(busy);
+        json.end_array();
+        json.end_object();
+    }
+
+    if (stats.has_dram) {
+        json.key("dram").begin_array();
+        for (const BankStats& bank : stats.dram.banks) {
+            json.begin_object();
+            json.member("reads", bank.reads);
+            json.member("writes", bank.writes);
+            json.member("row_hits", bank.row_hits);
+            json.member("row_empty", bank.row_empty);
+            json.member("row_conflicts", bank.row_conflicts);
+            json.end_object();
+        }
+        json.end_array();
+    }
+    json.end_object();
 }
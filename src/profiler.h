@@ -1,18 +1,34 @@
 #ifndef PROFILER_H
 #define PROFILER_H
 
+#include <string>
 #include <vector>
 
 #include "enums.h"
 #include "trace.h"
+#include "stats.h"
 
 class Bus;
+class Memory;
+class JsonWriter;
 
 class Profiler {
 public:
     Profiler(int num_cores);
     void update(InstructionType type, int core_id, int this_cycles, bool is_hit, CacheState from_state, CacheState to_state);
-    void print_stats(Bus* bus);
+    // cycles the core waited outside of any instruction, e.g. draining the store buffer
+    void add_stall_cycles(int core_id, int cycles);
+    // an instruction run in the fast mode, which only counts the instruction
+    void add_fast_forwarded(int core_id);
+    // cycles elapsed on a core so far
+    [[nodiscard]] long long get_core_cycles(int core_id) const;
+    // gather the counters of this profiler, the memories and the bus into a stats object
+    [[nodiscard]] SimulationStats collect(Bus* bus, const std::vector<Memory*>& memories) const;
+    static void print_stats(const SimulationStats& stats);
+    // print part / whole as a percentage with one decimal place
+    static void print_percentage(const std::string& label, long long part, long long whole);
+    // write the stats as one JSON object
+    static void write_json(const SimulationStats& stats, JsonWriter& json);
 
 private:
     int num_cores;
@@ -26,6 +42,7 @@ private:
 
     std::vector<long> loads_per_core;
     std::vector<long> stores_per_core;
+    std::vector<long> fast_forwarded_per_core;
 
     std::atomic<long> shared_accesses;
     std::atomic<long> private_accesses;
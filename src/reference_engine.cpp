@@ -0,0 +1,209 @@
+#include <cmath>
+
+#include "reference_engine.h"
+
+namespace {
+    bool is_dirty(CacheState state) {
+        return state == Modified || state == SharedModified || state == Dirty;
+    }
+
+    bool is_other_copy(BusResponse response) {
+        return response == BusResponseShared || response == BusResponseDirty;
+    }
+}
+
+ReferenceEngine::ReferenceEngine(const SimConfig& config, int num_cores)
+        : protocol(config.protocol), associativity(config.associativity), block_size(config.block_size),
+          latencies(config.latencies), traffic(0), invalidations_updates(0) {
+    int num_sets = config.cache_size / (config.block_size * config.associativity);
+    offset_bits = static_cast<int>(std::log2(config.block_size));
+    set_index_bits = static_cast<int>(std::log2(num_sets));
+    sets.assign(num_cores, std::vector<std::vector<Line>>(num_sets));
+}
+
+std::vector<ReferenceEngine::Line>& ReferenceEngine::lines_of(int core, uint32_t address) {
+    return sets[core][(address >> offset_bits) & ((1u << set_index_bits) - 1)];
+}
+
+const std::vector<ReferenceEngine::Line>& ReferenceEngine::lines_of(int core, uint32_t address) const {
+    return sets[core][(address >> offset_bits) & ((1u << set_index_bits) - 1)];
+}
+
+uint32_t ReferenceEngine::tag_of(uint32_t address) const {
+    return address >> (offset_bits + set_index_bits);
+}
+
+CacheState ReferenceEngine::get_state(int core, uint32_t address) const {
+    for (const Line& line : lines_of(core, address)) {
+        if (line.tag == tag_of(address)) return line.state;
+    }
+    return NotPresent;
+}
+
+long long ReferenceEngine::get_traffic() const {
+    return traffic * block_size;
+}
+
+long ReferenceEngine::get_invalidations_updates() const {
+    return invalidations_updates;
+}
+
+BusResponse ReferenceEngine::broadcast(BusMessage message, int sender, uint32_t address) {
+    if (message == BusUpdate) traffic++;
+
+    bool shared = false;
+    bool dirty = false;
+    for (int core = 0; core < static_cast<int>(sets.size()); core++) {
+        if (core == sender) continue;
+
+        BusResponse response = NoResponse;
+        for (Line& line : lines_of(core, address)) {
+            if (line.tag != tag_of(address)) continue;
+            CacheState& state = line.state;
+            switch (message) {
+            case Read:
+                if (state == Modified) { traffic++; state = Shared; response = BusResponseDirty; }
+                else if (state == Exclusive) { state = Shared; response = BusResponseShared; }
+                else if (state == Shared) { response = BusResponseShared; }
+                break;
+            case ReadExclusive:
+                if (state == Modified) { traffic++; state = Invalid; response = BusResponseDirty; }
+                else if (state == Exclusive || state == Shared) { state = Invalid; response = BusResponseShared; }
+                break;
+            case ReadDragon:
+                if (state == ExclusiveDragon) { state = SharedClean; response = BusResponseShared; }
+                else if (state == Dirty) { traffic++; state = SharedModified; response = BusResponseDirty; }
+                else if (state == SharedClean) { response = BusResponseShared; }
+                else if (state == SharedModified) { traffic++; response = BusResponseDirty; }
+                break;
+            case BusUpdate:
+                if (state == SharedClean) { response = BusResponseShared; }
+                else if (state == SharedModified) { state = SharedClean; response = BusResponseDirty; }
+                break;
+            default:
+                break;
+            }
+        }
+
+        shared = shared || response == BusResponseShared;
+        dirty = dirty || response == BusResponseDirty;
+        if (message == BusUpdate) invalidations_updates++;
+        if (message == ReadExclusive && response != NoResponse) invalidations_updates++;
+    }
+
+    BusResponse response = dirty ? BusResponseDirty : shared ? BusResponseShared : NoResponse;
+    // cache to cache transfer of the block
+    if ((message == Read || message == ReadExclusive || message == ReadDragon) && response != NoResponse) traffic++;
+    return response;
+}
+
+ReferenceEngine::Result ReferenceEngine::allocate(int core, uint32_t address, bool is_write, bool is_store) {
+    std::vector<Line>& lines = lines_of(core, address);
+
+    // the least recently used line makes room, written back if dirty
+    int write_back_cycles = 0;
+    if (static_cast<int>(lines.size()) == associativity) {
+        if (is_dirty(lines.back().state)) {
+            traffic++;
+            write_back_cycles = latencies.mem_flush;
+        }
+        lines.pop_back();
+    }
+
+    BusResponse response;
+    CacheState state;
+    if (protocol == MESI) {
+        response = broadcast(is_write ? ReadExclusive : Read, core, address);
+        state = is_write ? Modified : (is_other_copy(response) ? Shared : Exclusive);
+    } else {
+        response = broadcast(ReadDragon, core, address);
+        if (is_write && is_other_copy(response)) broadcast(BusUpdate, core, address);
+        state = is_write ? (is_other_copy(response) ? SharedModified : Dirty)
+                         : (is_other_copy(response) ? SharedClean : ExclusiveDragon);
+    }
+    lines.insert(lines.begin(), Line{tag_of(address), state});
+
+    // a Dragon store also sends the written word to the other copies
+    int words = protocol == Dragon && is_store ? 2 : 1;
+    int cycles = latencies.cache_hit + write_back_cycles;
+    if (response == BusResponseShared) cycles += words * latencies.send_word;
+    else if (response == BusResponseDirty) cycles += words * latencies.send_word + latencies.mem_flush;
+    else cycles += latencies.mem_fetch;
+    return {cycles, false, NotPresent, state};
+}
+
+ReferenceEngine::Result ReferenceEngine::load(int core, uint32_t address) {
+    std::vector<Line>& lines = lines_of(core, address);
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (lines[i].tag != tag_of(address)) continue;
+
+        Line line = lines[i];
+        lines.erase(lines.begin() + static_cast<long>(i));
+        CacheState from_state = line.state;
+        int cycles = latencies.cache_hit;
+        bool is_hit = true;
+        if (from_state == Invalid) {
+            // invalidated copy: read the block again
+            BusResponse response = broadcast(Read, core, address);
+            line.state = is_other_copy(response) ? Shared : Exclusive;
+            is_hit = false;
+            if (response == BusResponseShared) cycles += latencies.send_word;
+            else if (response == BusResponseDirty) cycles += latencies.send_word + latencies.mem_flush;
+            else cycles += latencies.mem_fetch;
+        }
+        lines.insert(lines.begin(), line);
+        return {cycles, is_hit, from_state, line.state};
+    }
+    return allocate(core, address, false, false);
+}
+
+ReferenceEngine::Result ReferenceEngine::store(int core, uint32_t address, bool exclusive) {
+    std::vector<Line>& lines = lines_of(core, address);
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (lines[i].tag != tag_of(address)) continue;
+
+        Line line = lines[i];
+        lines.erase(lines.begin() + static_cast<long>(i));
+        CacheState from_state = line.state;
+        int cycles = latencies.cache_hit;
+        bool is_hit = true;
+        if (protocol == MESI) {
+            BusResponse response = NoResponse;
+            if (from_state == Shared || from_state == Invalid) response = broadcast(ReadExclusive, core, address);
+            line.state = Modified;
+            if (from_state == Invalid) {
+                is_hit = false;
+                if (response == BusResponseShared) cycles += latencies.send_word;
+                else if (response == BusResponseDirty) cycles += latencies.send_word + latencies.mem_flush;
+                else cycles += latencies.mem_fetch;
+            }
+        } else if (from_state == SharedClean || from_state == SharedModified) {
+            BusResponse response = broadcast(BusUpdate, core, address);
+            line.state = is_other_copy(response) ? SharedModified : Dirty;
+            cycles += latencies.send_word;
+        } else {
+            line.state = Dirty;
+        }
+        lines.insert(lines.begin(), line);
+        return {cycles, is_hit, from_state, line.state};
+    }
+    // like the engine, a plain store miss brings the block in as a read; only atomics ask for ownership
+    return allocate(core, address, exclusive, true);
+}
+
+ReferenceEngine::Result ReferenceEngine::access(int core, InstructionType type, uint32_t address) {
+    switch (type) {
+    case LOAD:
+        return load(core, address);
+    case STORE:
+        return store(core, address, false);
+    case ATOMIC: {
+        Result result = store(core, address, true);
+        result.cycles += latencies.cache_hit;
+        return result;
+    }
+    default:
+        // without store buffers or MSHRs a fence has nothing to wait for
+        return {0, true, NotPresent, NotPresent};
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef REFERENCE_ENGINE_H
+#define REFERENCE_ENGINE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "enums.h"
+#include "sim_config.h"
+#include "trace.h"
+
+// the simplest model of the caches and the snooping bus, sharing no code with LRUSet, Bus or Memory:
+// the reference the optimized engine is checked against. It models the coherence protocol and timing of
+// plain caches only, without prefetchers, buffers, MSHRs, victim caches, TLBs or DRAM.
+class ReferenceEngine {
+public:
+    struct Result {
+        int cycles;
+        bool is_hit;
+        CacheState from_state;
+        CacheState to_state;
+    };
+
+    // perform a load, store, atomic or fence of a core
+    Result access(int core, InstructionType type, uint32_t address);
+    // state of the block holding address in the cache of a core, NotPresent if it holds none
+    [[nodiscard]] CacheState get_state(int core, uint32_t address) const;
+    // bus traffic in bytes, and invalidations or updates of other copies
+    [[nodiscard]] long long get_traffic() const;
+    [[nodiscard]] long get_invalidations_updates() const;
+
+    ReferenceEngine(const SimConfig& config, int num_cores);
+private:
+    struct Line {
+        uint32_t tag;
+        CacheState state;
+    };
+
+    // lines of a set, most recently used first
+    std::vector<Line>& lines_of(int core, uint32_t address);
+    const std::vector<Line>& lines_of(int core, uint32_t address) const;
+    uint32_t tag_of(uint32_t address) const;
+    // send message for address from sender to every other cache: returns the combined response
+    BusResponse broadcast(BusMessage message, int sender, uint32_t address);
+    // bring a missing block into the cache of core: returns the cycles of the miss
+    Result allocate(int core, uint32_t address, bool is_write, bool is_store);
+    Result load(int core, uint32_t address);
+    Result store(int core, uint32_t address, bool exclusive);
+
+    Protocol protocol;
+    int associativity;
+    int block_size;
+    int offset_bits;
+    int set_index_bits;
+    Latencies latencies;
+    // [core][set]
+    std::vector<std::vector<std::vector<Line>>> sets;
+    long long traffic;
+    long invalidations_updates;
+};
+
+#endif //REFERENCE_ENGINE_H
@@ -0,0 +1,269 @@
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "simulator.h"
+#include "profiler.h"
+#include "decoded_trace.h"
+#include "synthetic_trace.h"
+#include "json_writer.h"
+
+TraceCache::TraceCache(size_t _max_bytes) : max_bytes(_max_bytes), bytes(0) {}
+
+std::shared_ptr<const Trace> TraceCache::get(const std::string& filename, bool& was_cached) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto entry = entries.find(filename);
+        if (entry != entries.end()) {
+            lru.splice(lru.begin(), lru, entry->second.position);
+            was_cached = true;
+            return entry->second.trace;
+        }
+    }
+
+    // parse outside the lock so that jobs on other traces are not held up; if two jobs parse the
+    // same file at once, the first one to finish wins
+    was_cached = false;
+    auto trace = std::make_shared<Trace>();
+    if (!trace->read_data(filename)) return nullptr;
+    size_t trace_bytes = trace->get_instructions().size() * sizeof(Instruction);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    auto entry = entries.find(filename);
+    if (entry != entries.end()) return entry->second.trace;
+    while (!lru.empty() && bytes + trace_bytes > max_bytes) {
+        auto victim = entries.find(lru.back());
+        bytes -= victim->second.bytes;
+        entries.erase(victim);
+        lru.pop_back();
+    }
+    // a trace larger than the whole budget is used by this job but not kept
+    if (trace_bytes > max_bytes) return trace;
+    lru.push_front(filename);
+    entries[filename] = Entry{trace, trace_bytes, lru.begin()};
+    bytes += trace_bytes;
+    return trace;
+}
+
+Server::Server(const SimConfig& _base_config, int num_workers, size_t trace_cache_bytes)
+        : base_config(_base_config), trace_cache(trace_cache_bytes), stopping(false) {
+    for (int i = 0; i < std::max(1, num_workers); i++) {
+        workers.emplace_back(&Server::work, this);
+    }
+}
+
+Server::~Server() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    job_ready.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void Server::submit(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        jobs.push_back(std::move(job));
+    }
+    job_ready.notify_one();
+}
+
+void Server::work() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            job_ready.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job.reply(run_job(job.line));
+    }
+}
+
+std::string Server::run_job(const std::string& line) {
+    std::ostringstream result;
+    JsonWriter json(result);
+    std::string id;
+    auto fail = [&](const std::string& error) {
+        json.begin_object().member("id", id).member("status", "error").member("error", error).end_object();
+        return result.str();
+    };
+
+    SimConfig config = base_config;
+    std::string error;
+    std::istringstream tokens(line);
+    std::string token;
+    while (tokens >> token) {
+        if (token.rfind("--", 0) == 0) token = token.substr(2);
+        size_t equals = token.find('=');
+        std::string key = token.substr(0, equals);
+        std::string value = equals == std::string::npos ? "true" : token.substr(equals + 1);
+        if (key == "id") {
+            id = value;
+        } else if (!config.set(key, value, error)) {
+            return fail(error);
+        }
+    }
+    if (config.trace.empty()) return fail("No trace given.");
+    if (!config.validate(error)) return fail(error);
+
+    // the cached traces stay alive until the job has finished with them
+    std::vector<std::shared_ptr<const Trace>> traces;
+    int cached_traces = 0;
+    try {
+        Simulator simulator(config);
+        if (config.trace.rfind("synthetic:", 0) == 0) {
+            SyntheticPattern pattern;
+            std::string value = config.trace.substr(std::strlen("synthetic:"));
+            if (!SyntheticTrace::parse_pattern(value, pattern)) return fail("Unknown synthetic pattern '" + value + "'.");
+            for (int i = 0; i < config.cores; i++) {
+                simulator.add_core(new SyntheticTrace(pattern, i, config.synthetic_length, config.synthetic_seed));
+            }
+        } else {
+            for (int i = 0; i < config.cores; i++) {
+                std::string core_filename = config.trace + "_" + std::to_string(i) + ".data";
+                if (!std::filesystem::exists(core_filename)) break;
+
+                bool was_cached;
+                std::shared_ptr<const Trace> trace = trace_cache.get(core_filename, was_cached);
+                if (trace == nullptr) return fail("Unable to read trace '" + core_filename + "'.");
+                cached_traces += was_cached;
+                traces.push_back(trace);
+
+                if (config.predecode) {
+                    DecodedTrace* decoded = new DecodedTrace();
+                    decoded->decode(*trace, simulator.get_offset_bits(), simulator.get_set_index_bits());
+                    simulator.add_core(decoded);
+                } else {
+                    simulator.add_core(std::span<const Instruction>(trace->get_instructions()));
+                }
+            }
+            if (traces.empty()) return fail("No trace files found for '" + config.trace + "'.");
+        }
+
+        SimulationStats stats = simulator.run();
+        json.begin_object().member("id", id).member("status", "ok");
+        json.member("cached_traces", cached_traces);
+        json.key("stats");
+        Profiler::write_json(stats, json);
+        json.end_object();
+        return result.str();
+    } catch (const std::exception& e) {
+        return fail(e.what());
+    }
+}
+
+void Server::serve_stream(std::istream& in, std::ostream& out) {
+    // results are written whole, one per line, in the order the jobs finish
+    std::mutex out_mtx;
+    std::condition_variable done;
+    int pending = 0;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos || line[0] == '#') continue;
+        {
+            std::lock_guard<std::mutex> lock(out_mtx);
+            pending++;
+        }
+        submit(Job{line, [&](const std::string& result) {
+            std::lock_guard<std::mutex> lock(out_mtx);
+            out << result << std::endl;
+            pending--;
+            done.notify_all();
+        }});
+    }
+
+    std::unique_lock<std::mutex> lock(out_mtx);
+    done.wait(lock, [&pending]() { return pending == 0; });
+}
+
+bool Server::serve_socket(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path '" << path << "' is too long." << std::endl;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Unable to create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // a socket file left behind by a previous server would make bind fail
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, SOMAXCONN) < 0) {
+        std::cerr << "Unable to listen on '" << path << "': " << std::strerror(errno) << std::endl;
+        close(listener);
+        return false;
+    }
+
+    std::cerr << "Listening on '" << path << "'." << std::endl;
+    while (true) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Unable to accept connection: " << std::strerror(errno) << std::endl;
+            close(listener);
+            return false;
+        }
+        std::thread(&Server::serve_connection, this, fd).detach();
+    }
+}
+
+void Server::serve_connection(int fd) {
+    // the connection is closed once the peer has stopped sending and every result has been written back
+    struct Connection {
+        int fd;
+        std::mutex mtx;
+
+        explicit Connection(int _fd) : fd(_fd) {}
+        ~Connection() { close(fd); }
+
+        void send(const std::string& result) {
+            std::string line = result + "\n";
+            std::lock_guard<std::mutex> lock(mtx);
+            size_t sent = 0;
+            while (sent < line.size()) {
+                ssize_t n = ::send(fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR) continue;
+                // the peer went away: the remaining results have nowhere to go
+                if (n <= 0) return;
+                sent += static_cast<size_t>(n);
+            }
+        }
+    };
+    auto connection = std::make_shared<Connection>(fd);
+
+    std::string pending;
+    char buffer[4096];
+    while (true) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        pending.append(buffer, static_cast<size_t>(n));
+
+        size_t newline;
+        while ((newline = pending.find('\n')) != std::string::npos) {
+            std::string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            if (line.find_first_not_of(" \t\r") == std::string::npos || line[0] == '#') continue;
+            submit(Job{line, [connection](const std::string& result) { connection->send(result); }});
+        }
+    }
+    if (pending.find_first_not_of(" \t\r") != std::string::npos) {
+        submit(Job{pending, [connection](const std::string& result) { connection->send(result); }});
+    }
+}
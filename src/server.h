@@ -0,0 +1,82 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "sim_config.h"
+#include "trace.h"
+
+// parsed trace files kept in memory across jobs; beyond the byte budget the least recently used ones are
+// dropped, though jobs still running on a dropped trace keep it alive
+class TraceCache {
+public:
+    // the trace read from filename, parsed on first use: nullptr if it cannot be read
+    std::shared_ptr<const Trace> get(const std::string& filename, bool& was_cached);
+
+    explicit TraceCache(size_t _max_bytes);
+private:
+    struct Entry {
+        std::shared_ptr<const Trace> trace;
+        size_t bytes;
+        std::list<std::string>::iterator position;
+    };
+
+    std::mutex mtx;
+    size_t max_bytes;
+    size_t bytes;
+    // most recently used first
+    std::list<std::string> lru;
+    std::unordered_map<std::string, Entry> entries;
+};
+
+// long-running batch mode: reads jobs, one per line, runs them concurrently on a pool of workers and
+// writes back one JSON object per job as it finishes.
+// A job is a list of "key=value" options as in the configuration file, e.g.
+//   id=run1 protocol=MESI trace=traces/bodytrack cache_size=4096 associativity=2 block_size=32
+// applied on top of the options the server was started with; "id" is echoed back in the result.
+class Server {
+public:
+    // serve the jobs read from in, writing results to out, until in ends and all of its jobs have finished
+    void serve_stream(std::istream& in, std::ostream& out);
+    // serve the connections to a Unix domain socket at path, each a stream of jobs and results;
+    // returns false if the socket cannot be set up
+    bool serve_socket(const std::string& path);
+
+    Server(const SimConfig& _base_config, int num_workers, size_t trace_cache_bytes);
+    ~Server();
+private:
+    struct Job {
+        std::string line;
+        // called from a worker with the JSON result of the job
+        std::function<void(const std::string&)> reply;
+    };
+
+    void submit(Job job);
+    void work();
+    // run the job described by line: returns its JSON result
+    std::string run_job(const std::string& line);
+    // read jobs from a connected socket until the peer closes it
+    void serve_connection(int fd);
+
+    SimConfig base_config;
+    TraceCache trace_cache;
+
+    std::mutex mtx;
+    std::condition_variable job_ready;
+    std::deque<Job> jobs;
+    bool stopping;
+    std::vector<std::thread> workers;
+};
+
+#endif //SERVER_H
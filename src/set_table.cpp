@@ -0,0 +1,70 @@
+#include "set_table.h"
+
+SetTable::SetTable(int _num_sets, int _associativity, Protocol _protocol) :
+        num_sets(_num_sets), associativity(_associativity), protocol(_protocol), sectors(1), sector_offset_bits(0),
+        num_chunks((_num_sets + SETS_PER_CHUNK - 1) / SETS_PER_CHUNK),
+        used_in_last_slab(SETS_PER_SLAB), num_allocated(0) {
+    directory = std::make_unique<std::atomic<Chunk*>[]>(num_chunks);
+    for (int i = 0; i < num_chunks; i++) directory[i].store(nullptr, std::memory_order_relaxed);
+}
+
+SetTable::~SetTable() {
+    for (int i = 0; i < num_chunks; i++) delete directory[i].load(std::memory_order_relaxed);
+
+    // destroy the sets constructed in each slab, then give the slabs back
+    for (size_t i = 0; i < slabs.size(); i++) {
+        int used = i + 1 == slabs.size() ? used_in_last_slab : SETS_PER_SLAB;
+        for (int j = 0; j < used; j++) slabs[i][j].~LRUSet();
+        slab_allocator.deallocate(slabs[i], SETS_PER_SLAB);
+    }
+}
+
+void SetTable::set_sectors(int _sectors, int _sector_offset_bits) {
+    sectors = _sectors;
+    sector_offset_bits = _sector_offset_bits;
+}
+
+LRUSet* SetTable::find(uint32_t set_index) const {
+    Chunk* chunk = directory[set_index / SETS_PER_CHUNK].load(std::memory_order_acquire);
+    if (chunk == nullptr) return nullptr;
+    return chunk->sets[set_index % SETS_PER_CHUNK].load(std::memory_order_acquire);
+}
+
+LRUSet* SetTable::get(uint32_t set_index) {
+    LRUSet* set = find(set_index);
+    if (set != nullptr) return set;
+    return allocate_set(set_index);
+}
+
+LRUSet* SetTable::allocate_set(uint32_t set_index) {
+    // sets are normally allocated by their core's thread, but snoops may race with it, so allocation is
+    // serialised and published with release stores for the lock-free find
+    std::lock_guard<std::mutex> lock(arena_mtx);
+
+    std::atomic<Chunk*>& chunk_slot = directory[set_index / SETS_PER_CHUNK];
+    Chunk* chunk = chunk_slot.load(std::memory_order_relaxed);
+    if (chunk == nullptr) {
+        chunk = new Chunk();
+        for (std::atomic<LRUSet*>& slot : chunk->sets) slot.store(nullptr, std::memory_order_relaxed);
+        chunk_slot.store(chunk, std::memory_order_release);
+    }
+
+    std::atomic<LRUSet*>& set_slot = chunk->sets[set_index % SETS_PER_CHUNK];
+    LRUSet* set = set_slot.load(std::memory_order_relaxed);
+    if (set != nullptr) return set;
+
+    if (used_in_last_slab == SETS_PER_SLAB) {
+        slabs.push_back(slab_allocator.allocate(SETS_PER_SLAB));
+        used_in_last_slab = 0;
+    }
+    set = new (slabs.back() + used_in_last_slab) LRUSet(associativity, protocol, sectors, sector_offset_bits);
+    used_in_last_slab++;
+    num_allocated++;
+
+    set_slot.store(set, std::memory_order_release);
+    return set;
+}
+
+long SetTable::get_num_allocated() const {
+    return num_allocated;
+}
@@ -0,0 +1,56 @@
+#ifndef SET_TABLE_H
+#define SET_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "cache.h"
+
+// LRU sets of a cache, allocated on first touch from a pooled arena: a set that is never accessed costs
+// nothing, and construction only allocates a directory of one pointer per SETS_PER_CHUNK sets
+class SetTable {
+public:
+    // set with the given index, or nullptr if it was never touched (an untouched set holds no lines)
+    [[nodiscard]] LRUSet* find(uint32_t set_index) const;
+    // set with the given index, allocated on first touch
+    LRUSet* get(uint32_t set_index);
+    [[nodiscard]] long get_num_allocated() const;
+    // split the lines of sets allocated from now on into sectors of 2^sector_offset_bits bytes
+    void set_sectors(int _sectors, int _sector_offset_bits);
+
+    SetTable(int _num_sets, int _associativity, Protocol _protocol);
+    ~SetTable();
+    SetTable(const SetTable&) = delete;
+    SetTable& operator=(const SetTable&) = delete;
+private:
+    static constexpr int SETS_PER_CHUNK = 256;
+    static constexpr int SETS_PER_SLAB = 64;
+
+    struct Chunk {
+        std::atomic<LRUSet*> sets[SETS_PER_CHUNK];
+    };
+
+    int num_sets;
+    int associativity;
+    Protocol protocol;
+    int sectors;
+    int sector_offset_bits;
+
+    // directory of chunks indexed by set index / SETS_PER_CHUNK; a chunk is allocated with its first set
+    std::unique_ptr<std::atomic<Chunk*>[]> directory;
+    int num_chunks;
+
+    // arena the sets are constructed in, so that allocating a set is a pointer bump
+    std::mutex arena_mtx;
+    std::allocator<LRUSet> slab_allocator;
+    std::vector<LRUSet*> slabs;
+    int used_in_last_slab;
+    long num_allocated;
+
+    LRUSet* allocate_set(uint32_t set_index);
+};
+
+#endif //SET_TABLE_H
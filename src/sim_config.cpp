@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "sim_config.h"
+
+namespace {
+    std::string trim(const std::string& s) {
+        size_t begin = s.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) return "";
+        size_t end = s.find_last_not_of(" \t\r");
+        return s.substr(begin, end - begin + 1);
+    }
+
+    bool parse_int(const std::string& value, long long min, long long& result) {
+        try {
+            size_t end = 0;
+            result = std::stoll(value, &end, 0);
+            return end == value.size() && result >= min;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    bool parse_int(const std::string& value, long long min, int& result) {
+        long long parsed;
+        if (!parse_int(value, min, parsed) || parsed > INT32_MAX) return false;
+        result = static_cast<int>(parsed);
+        return true;
+    }
+
+    // a size in bytes, optionally with a K, M or G suffix
+    bool parse_size(const std::string& value, long long& result) {
+        if (value.empty()) return false;
+        long long multiplier = 1;
+        std::string digits = value;
+        switch (value.back()) {
+        case 'K': case 'k': multiplier = 1LL << 10; break;
+        case 'M': case 'm': multiplier = 1LL << 20; break;
+        case 'G': case 'g': multiplier = 1LL << 30; break;
+        default: break;
+        }
+        if (multiplier != 1) digits.pop_back();
+        long long parsed;
+        if (!parse_int(digits, 1, parsed) || parsed > INT64_MAX / multiplier) return false;
+        result = parsed * multiplier;
+        return true;
+    }
+
+    bool parse_size(const std::string& value, int& result) {
+        long long parsed;
+        if (!parse_size(value, parsed) || parsed > INT32_MAX) return false;
+        result = static_cast<int>(parsed);
+        return true;
+    }
+
+    // settings of the private cache that can differ between cores; the block size and everything shared,
+    // like main memory, stay common so that the caches remain coherent
+    bool is_core_key(const std::string& key) {
+        return key == "cache_size" || key == "associativity" || key == "cache_hit_time" || key == "send_word_time"
+               || key == "victim_hit_time";
+    }
+
+    // whether a cache of this geometry holds a whole, power-of-two number of sets, as its set index bits need
+    bool has_power_of_two_sets(int cache_size, int associativity, int block_size) {
+        const long long set_size = static_cast<long long>(block_size) * associativity;
+        const long long sets = cache_size / set_size;
+        return cache_size % set_size == 0 && sets >= 1 && (sets & (sets - 1)) == 0;
+    }
+
+    bool parse_bool(const std::string& value, bool& result) {
+        if (value == "true" || value == "yes" || value == "on" || value == "1") result = true;
+        else if (value == "false" || value == "no" || value == "off" || value == "0") result = false;
+        else return false;
+        return true;
+    }
+}
+
+bool SimConfig::set(const std::string& _key, const std::string& value, std::string& error) {
+    std::string key = _key;
+    std::replace(key.begin(), key.end(), '-', '_');
+
+    // "core<n>.<key>" overrides key for core n
+    size_t dot = key.find('.');
+    if (key.rfind("core", 0) == 0 && dot != std::string::npos) {
+        int core;
+        std::string core_key = key.substr(dot + 1);
+        if (!parse_int(key.substr(4, dot - 4), 0, core) || !is_core_key(core_key)) {
+            error = "Unknown option '" + _key + "'.";
+            return false;
+        }
+        SimConfig scratch;
+        if (!scratch.set(core_key, value, error)) {
+            error = "Invalid value '" + value + "' for option '" + _key + "'.";
+            return false;
+        }
+        core_overrides[core].emplace_back(core_key, value);
+        return true;
+    }
+
+    bool valid = true;
+    if (key == "protocol") {
+        if (value == "MESI") protocol = MESI;
+        else if (value == "Dragon") protocol = Dragon;
+        else valid = false;
+    } else if (key == "trace") {
+        trace = value;
+    } else if (key == "cache_size") {
+        valid = parse_int(value, 1, cache_size);
+    } else if (key == "associativity") {
+        valid = parse_int(value, 1, associativity);
+    } else if (key == "block_size") {
+        valid = parse_int(value, 4, block_size);
+    } else if (key == "cores") {
+        valid = parse_int(value, 1, cores);
+    } else if (key == "cache_hit_time") {
+        valid = parse_int(value, 0, latencies.cache_hit);
+    } else if (key == "send_word_time") {
+        valid = parse_int(value, 0, latencies.send_word);
+    } else if (key == "mem_fetch_time") {
+        valid = parse_int(value, 0, latencies.mem_fetch);
+    } else if (key == "mem_flush_time") {
+        valid = parse_int(value, 0, latencies.mem_flush);
+    } else if (key == "victim_hit_time") {
+        valid = parse_int(value, 0, latencies.victim_hit);
+    } else if (key == "prefetcher") {
+        if (value == "next-line") prefetcher = NextLine;
+        else if (value == "stride") prefetcher = Stride;
+        else if (value == "stream") prefetcher = StreamBuffer;
+        else if (value == "none") prefetcher = NoPrefetcher;
+        else valid = false;
+    } else if (key == "store_buffer") {
+        valid = parse_int(value, 0, store_buffer);
+    } else if (key == "mshrs") {
+        valid = parse_int(value, 0, mshrs);
+    } else if (key == "overlap_window") {
+        valid = parse_int(value, 0, overlap_window);
+    } else if (key == "sectors") {
+        valid = parse_int(value, 1, sectors) && sectors <= Config::MAX_SECTORS && (sectors & (sectors - 1)) == 0;
+    } else if (key == "victim_cache") {
+        valid = parse_int(value, 0, victim_cache);
+    } else if (key == "dram") {
+        use_dram = value != "none";
+        if (value == "open") page_policy = OpenPage;
+        else if (value == "closed") page_policy = ClosedPage;
+        else if (value != "none") valid = false;
+    } else if (key == "dram_channels") {
+        valid = parse_int(value, 1, dram_channels);
+    } else if (key == "dram_banks") {
+        valid = parse_int(value, 1, dram_banks);
+    } else if (key == "interconnect") {
+        if (value == "bus") interconnect = SharedBus;
+        else if (value == "mesh") interconnect = MeshNetwork;
+        else valid = false;
+    } else if (key == "mesh_width") {
+        valid = parse_int(value, 0, mesh_width);
+    } else if (key == "mesh_height") {
+        valid = parse_int(value, 0, mesh_height);
+    } else if (key == "hop_time") {
+        valid = parse_int(value, 0, hop_time);
+    } else if (key == "link_width") {
+        valid = parse_int(value, 1, link_width);
+    } else if (key == "llc_slice_size") {
+        // e.g. 256K, or 0 for a mesh without a last-level cache
+        if (value == "0") llc_slice_size = 0;
+        else valid = parse_size(value, llc_slice_size);
+    } else if (key == "llc_associativity") {
+        valid = parse_int(value, 1, llc_associativity);
+    } else if (key == "llc_hit_time") {
+        valid = parse_int(value, 0, llc_hit_time);
+    } else if (key == "tlb") {
+        valid = parse_bool(value, tlb);
+    } else if (key == "tlb_l1_entries") {
+        valid = parse_int(value, 1, tlb_l1_entries);
+    } else if (key == "tlb_l2_entries") {
+        valid = parse_int(value, 0, tlb_l2_entries);
+    } else if (key == "page_size") {
+        // e.g. 4K, or 2M / 4M for huge pages
+        valid = parse_size(value, page_size) && (page_size & (page_size - 1)) == 0;
+    } else if (key == "predecode") {
+        valid = parse_bool(value, predecode);
+    } else if (key == "decode_cache") {
+        // decoded traces are cached on disk, so predecoding is implied
+        decode_cache_dir = value;
+        predecode = predecode || !value.empty();
+    } else if (key == "executor") {
+        if (value == "threads") executor = ThreadPerCore;
+        else if (value == "serial") executor = RoundRobin;
+        else if (value == "coroutines") executor = Coroutines;
+        else valid = false;
+    } else if (key == "record") {
+        record_interleaving = value;
+    } else if (key == "replay") {
+        replay_interleaving = value;
+    } else if (key == "host_threads") {
+        valid = parse_int(value, 0, host_threads);
+    } else if (key == "pin") {
+        pin_cpus.clear();
+        if (value == "none") pin = NoPinning;
+        else if (value == "compact") pin = PinCompact;
+        else if (value == "spread") pin = PinSpread;
+        else {
+            // a comma separated list of host CPUs, one per core
+            pin = PinList;
+            std::stringstream ss(value);
+            std::string cpu;
+            while (valid && std::getline(ss, cpu, ',')) {
+                pin_cpus.emplace_back();
+                valid = parse_int(trim(cpu), 0, pin_cpus.back());
+            }
+            valid = valid && !pin_cpus.empty();
+        }
+    } else if (key == "huge_pages") {
+        valid = parse_bool(value, huge_pages);
+    } else if (key == "host_perf") {
+        valid = parse_bool(value, host_perf);
+    } else if (key == "workers") {
+        valid = parse_int(value, 0, server_workers);
+    } else if (key == "trace_cache") {
+        valid = parse_size(value, trace_cache_size);
+    } else if (key == "window") {
+        valid = parse_int(value, 1, analysis_window);
+    } else if (key == "length") {
+        valid = parse_int(value, 0, synthetic_length);
+    } else if (key == "seed") {
+        long long seed;
+        valid = parse_int(value, 0, seed);
+        synthetic_seed = static_cast<uint64_t>(seed);
+    } else {
+        error = "Unknown option '" + _key + "'.";
+        return false;
+    }
+
+    if (!valid) error = "Invalid value '" + value + "' for option '" + _key + "'.";
+    return valid;
+}
+
+bool SimConfig::load_file(const std::string& path, std::string& error) {
+    std::ifstream infile(path);
+    if (!infile) {
+        error = "Unable to open configuration file '" + path + "'.";
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    std::string prefix;
+    while (std::getline(infile, line)) {
+        line_number++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+        if (line[0] == '[') {
+            std::string section = trim(line.substr(1, line.find(']') - 1));
+            prefix = section.rfind("core", 0) == 0 ? section + "." : "";
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            error = path + ":" + std::to_string(line_number) + ": expected 'key = value'.";
+            return false;
+        }
+        std::string value = trim(line.substr(equals + 1));
+        // values may be quoted, as in TOML
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') value = value.substr(1, value.size() - 2);
+        if (!set(prefix + trim(line.substr(0, equals)), value, error)) {
+            error = path + ":" + std::to_string(line_number) + ": " + error;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SimConfig::validate(std::string& error) const {
+    if (sectors > 1 && (victim_cache > 0 || block_size / sectors < 4)) {
+        error = "Sectored lines need sectors of at least 4 bytes and no victim cache.";
+        return false;
+    }
+    // decoded instructions keep only the tag and set index of an address, not the sector it falls in
+    if (sectors > 1 && predecode) {
+        error = "Sectored lines cannot be simulated on predecoded traces.";
+        return false;
+    }
+    if ((block_size & (block_size - 1)) != 0) {
+        error = "The block size must be a power of two.";
+        return false;
+    }
+    if (!has_power_of_two_sets(cache_size, associativity, block_size)) {
+        error = "The cache must hold a power-of-two number of sets of " + std::to_string(block_size) + "-byte blocks.";
+        return false;
+    }
+    for (const auto& [core, overrides] : core_overrides) {
+        if (core >= cores) {
+            error = "Core " + std::to_string(core) + " has overrides, but only " + std::to_string(cores)
+                    + " cores are simulated.";
+            return false;
+        }
+        const SimConfig core_config = for_core(core);
+        if (!has_power_of_two_sets(core_config.cache_size, core_config.associativity, block_size)) {
+            error = "The cache of core " + std::to_string(core) + " must hold a power-of-two number of sets of "
+                    + std::to_string(block_size) + "-byte blocks.";
+            return false;
+        }
+    }
+    if (interconnect == MeshNetwork) {
+        // every core needs a tile of its own
+        auto [width, height] = get_mesh_size();
+        if (width * height < cores) {
+            error = "A " + std::to_string(width) + "x" + std::to_string(height) + " mesh has fewer tiles than the "
+                    + std::to_string(cores) + " cores.";
+            return false;
+        }
+    }
+    if (llc_slice_size % (block_size * llc_associativity) != 0) {
+        error = "LLC slices must hold a whole number of sets of the block size and LLC associativity.";
+        return false;
+    }
+    return true;
+}
+
+SimConfig SimConfig::for_core(int core) const {
+    SimConfig config = *this;
+    auto overrides = core_overrides.find(core);
+    if (overrides == core_overrides.end()) return config;
+    // the values were checked when they were set
+    std::string unused;
+    for (const auto& [key, value] : overrides->second) config.set(key, value, unused);
+    return config;
+}
+
+std::pair<int, int> SimConfig::get_mesh_size() const {
+    int width = mesh_width;
+    int height = mesh_height;
+    if (width == 0 && height == 0) {
+        width = 1;
+        while (width * width < cores) width++;
+    }
+    if (width == 0) width = (cores + height - 1) / height;
+    if (height == 0) height = (cores + width - 1) / width;
+    return {std::max(width, 1), std::max(height, 1)};
+}
@@ -0,0 +1,102 @@
+#ifndef SIM_CONFIG_H
+#define SIM_CONFIG_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+#include "enums.h"
+
+// latencies of the memory system in cycles, defaulting to the compiled-in values
+struct Latencies {
+    int cache_hit = Config::CACHE_HIT_TIME;
+    int send_word = Config::SEND_WORD_TIME;
+    int mem_fetch = Config::MEM_FETCH_TIME;
+    int mem_flush = Config::MEM_FLUSH_TIME;
+    int victim_hit = Config::VICTIM_HIT_TIME;
+};
+
+// settings of a simulation run: the defaults, overridden by a configuration file and then by the command line
+struct SimConfig {
+    Protocol protocol = MESI;
+    // trace file prefix, or "synthetic:<pattern>"
+    std::string trace;
+    int cache_size = 4096;
+    int associativity = 2;
+    int block_size = 32;
+    int cores = Config::NUM_CORES;
+    Latencies latencies;
+
+    PrefetcherType prefetcher = NoPrefetcher;
+    int store_buffer = 0;
+    int mshrs = 0;
+    int overlap_window = Config::MSHR_OVERLAP_WINDOW;
+    int victim_cache = 0;
+    // sectors per line, each with its own valid and coherence state (1: lines are not sectored)
+    int sectors = 1;
+    InterconnectType interconnect = SharedBus;
+    // mesh dimensions in tiles: 0 picks the most square mesh with a tile for every core
+    int mesh_width = 0;
+    int mesh_height = 0;
+    int hop_time = Config::MESH_HOP_TIME;
+    int link_width = Config::MESH_LINK_WIDTH;
+    // bytes of last-level cache per tile (0 for none), its associativity and its hit time
+    int llc_slice_size = Config::LLC_SLICE_SIZE;
+    int llc_associativity = Config::LLC_ASSOCIATIVITY;
+    int llc_hit_time = Config::LLC_HIT_TIME;
+    bool use_dram = false;
+    PagePolicy page_policy = OpenPage;
+    int dram_channels = Config::DRAM_CHANNELS;
+    int dram_banks = Config::DRAM_BANKS;
+    // virtual memory: TLB sizes are only used when tlb is set
+    bool tlb = false;
+    int tlb_l1_entries = Config::TLB_L1_ENTRIES;
+    int tlb_l2_entries = Config::TLB_L2_ENTRIES;
+    int page_size = Config::PAGE_SIZE;
+    bool predecode = false;
+    std::string decode_cache_dir;
+    ExecutorType executor = ThreadPerCore;
+    // host threads of the coroutine executor: 1 runs the cores in clock order on the calling thread,
+    // 0 uses every hardware thread
+    int host_threads = 1;
+    // record the order of the memory system steps of a threaded run to this file, or replay the order
+    // recorded in this file on the calling thread
+    std::string record_interleaving;
+    std::string replay_interleaving;
+    // pin each thread of the thread-per-core executor to a host CPU (pin_cpus lists them for PinList) and move
+    // its core's trace to the CPU's NUMA node, asking for transparent huge pages if huge_pages is set
+    PinPolicy pin = NoPinning;
+    std::vector<int> pin_cpus;
+    bool huge_pages = false;
+    // count host hardware events of the simulator itself with perf_event_open
+    bool host_perf = false;
+    // server mode: concurrent jobs (0 for one per hardware thread) and the memory kept for parsed traces
+    int server_workers = 0;
+    long long trace_cache_size = Config::TRACE_CACHE_SIZE;
+    // trace analysis: accesses per working set window
+    long long analysis_window = Config::ANALYSIS_WINDOW;
+    long long synthetic_length = Config::SYNTHETIC_LENGTH;
+    uint64_t synthetic_seed = 1;
+    // per-core overrides of the private cache, as "core<n>.<key>" = value: core -> {key, value} in order
+    std::map<int, std::vector<std::pair<std::string, std::string>>> core_overrides;
+
+    // set the option key (as named on the command line, '-' and '_' are interchangeable) to value:
+    // returns false and describes the problem in error if the key is unknown or the value invalid
+    bool set(const std::string& key, const std::string& value, std::string& error);
+    // read "key = value" lines from an INI-style file; lines starting with '#' or ';' are comments and
+    // "[section]" headers only group keys, except that keys under "[core<n>]" override the cache of core n
+    bool load_file(const std::string& path, std::string& error);
+    // check the settings against each other once they are all set: returns false and describes the problem
+    // in error if they cannot be simulated together
+    bool validate(std::string& error) const;
+    // the settings of core's private cache: cache_size, associativity and the cache latencies, with the
+    // overrides of that core applied
+    [[nodiscard]] SimConfig for_core(int core) const;
+    // {width, height} of the mesh: as configured, with any dimension left at 0 chosen to fit the cores
+    [[nodiscard]] std::pair<int, int> get_mesh_size() const;
+};
+
+#endif //SIM_CONFIG_H
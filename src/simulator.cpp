@@ -0,0 +1,110 @@
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#include "simulator.h"
+#include "config.h"
+#include "memory.h"
+#include "decoded_trace.h"
+#include "prefetcher.h"
+
+Simulator::Simulator(const SimConfig& _config)
+        : config(_config), bus(_config.block_size),
+          memory_controller(_config.dram_channels, _config.dram_banks, _config.page_policy),
+          mesh(_config.get_mesh_size().first, _config.get_mesh_size().second, _config.hop_time, _config.link_width,
+               _config.block_size, _config.llc_slice_size, _config.llc_associativity, _config.llc_hit_time), num_cores(0),
+          recording(nullptr), replaying(nullptr) {
+    bus.set_memory_latencies(config.latencies.mem_fetch, config.latencies.mem_flush);
+    bus.set_sector_size(config.block_size / config.sectors);
+    if (config.use_dram) bus.connect_memory_controller(&memory_controller);
+    if (config.interconnect == MeshNetwork) bus.connect_mesh(&mesh);
+    cpu.connect_bus(&bus);
+    cpu.set_host_perf(config.host_perf);
+    cpu.set_placement(config.pin, config.pin_cpus, config.huge_pages);
+}
+
+Memory* Simulator::create_memory() {
+    // the private cache of this core: its size, associativity and latencies may be overridden per core
+    const SimConfig core_config = config.for_core(num_cores);
+    Memory* memory = new Memory(num_cores++, core_config.cache_size, core_config.associativity, config.block_size,
+                                Config::ADDRESS_BITS, config.protocol);
+    memory->set_latencies(core_config.latencies);
+    memory->set_sectors(config.sectors);
+    memory->set_prefetcher(Prefetcher::create(config.prefetcher, config.block_size));
+    memory->set_store_buffer_size(config.store_buffer);
+    memory->set_mshrs(config.mshrs, config.overlap_window);
+    memory->set_victim_cache_size(config.victim_cache);
+    if (config.tlb) memory->set_tlb(config.tlb_l1_entries, config.tlb_l2_entries, config.page_size);
+    bus.connect_memory(memory);
+
+    int offset_bits = memory->get_offset_bits();
+    int set_index_bits = memory->get_set_index_bits();
+    std::cout << "Memory initialized. Offset: " << offset_bits << " bits. Set Index: "
+              << set_index_bits << " bits. Tag: " << Config::ADDRESS_BITS - offset_bits - set_index_bits << " bits. "
+              << memory->get_num_sets() << " sets, " << core_config.associativity << "-way associative." << std::endl;
+    return memory;
+}
+
+void Simulator::add_core(std::span<const Instruction> instructions) {
+    add_core(new SpanTrace(instructions));
+}
+
+void Simulator::add_core(BatchSource source, TraceMarkers markers) {
+    add_core(new BatchTrace(std::move(source), num_cores, markers));
+}
+
+void Simulator::add_pushed_core(TraceMarkers markers) {
+    BatchQueue* queue = (queues[num_cores] = std::make_unique<BatchQueue>(Config::PUSH_QUEUE_BATCHES)).get();
+    add_core([queue](int) { return queue->pop(); }, markers);
+}
+
+void Simulator::push(int core, std::span<const Instruction> batch) {
+    queues.at(core)->push(batch);
+}
+
+void Simulator::close(int core) {
+    queues.at(core)->close();
+}
+
+void Simulator::add_core(Trace* trace) {
+    cpu.add_core(trace, create_memory());
+}
+
+void Simulator::add_core(DecodedTrace* trace) {
+    cpu.add_core(trace, create_memory());
+}
+
+int Simulator::get_num_cores() const {
+    return num_cores;
+}
+
+int Simulator::get_offset_bits() const {
+    return static_cast<int>(std::log2(config.block_size));
+}
+
+int Simulator::get_set_index_bits() const {
+    const SimConfig core_config = config.for_core(num_cores);
+    return static_cast<int>(std::log2(core_config.cache_size / (config.block_size * core_config.associativity)));
+}
+
+void Simulator::record_interleaving(InterleavingLog* log) {
+    recording = log;
+}
+
+void Simulator::replay_interleaving(const InterleavingLog* log) {
+    replaying = log;
+}
+
+SimulationStats Simulator::run() {
+    if (replaying != nullptr) return cpu.run_replay(*replaying);
+    switch (config.executor) {
+    case RoundRobin:
+        return cpu.run_serial();
+    case Coroutines:
+        return cpu.run_coroutines(config.host_threads > 0 ? config.host_threads
+                                                          : static_cast<int>(std::thread::hardware_concurrency()));
+    case ThreadPerCore:
+    default:
+        return cpu.run_parallel(recording);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <memory>
+#include <span>
+#include <unordered_map>
+
+#include "sim_config.h"
+#include "stats.h"
+#include "bus.h"
+#include "dram.h"
+#include "mesh.h"
+#include "cpu.h"
+#include "trace.h"
+#include "buffer_trace.h"
+
+class Memory;
+class DecodedTrace;
+class InterleavingLog;
+
+// entry point for embedding the simulator: configure it, add one trace per core and run it
+class Simulator {
+public:
+    // add a core fed in place from a caller-owned buffer, which must outlive run()
+    void add_core(std::span<const Instruction> instructions);
+    // add a core fed batch by batch from source, whose batches hold the given markers: run() rejects a
+    // warm-up end or region-of-interest begin marker that was not declared
+    void add_core(BatchSource source, TraceMarkers markers = TraceMarkers());
+    // add a core fed by push() from another thread while run() runs; it is core get_num_cores() - 1
+    void add_pushed_core(TraceMarkers markers = TraceMarkers());
+    // copy the next batch of a pushed core into its queue, waiting while Config::PUSH_QUEUE_BATCHES batches are
+    // queued: throws std::out_of_range if the core is not a pushed one
+    void push(int core, std::span<const Instruction> batch);
+    // end the trace of a pushed core once its queued batches have run
+    void close(int core);
+    // add a core running a trace; the simulator takes ownership of it
+    void add_core(Trace* trace);
+    void add_core(DecodedTrace* trace);
+    [[nodiscard]] int get_num_cores() const;
+    // geometry of the cache of the next core added, e.g. to pre-decode its trace
+    [[nodiscard]] int get_offset_bits() const;
+    [[nodiscard]] int get_set_index_bits() const;
+    // record the order of the steps of the threaded run into log (nullptr stops recording)
+    void record_interleaving(InterleavingLog* log);
+    // replay the order in log instead of running the configured executor (nullptr stops replaying)
+    void replay_interleaving(const InterleavingLog* log);
+    // run every core to the end of its trace with the configured executor; a simulator runs once. Throws
+    // std::invalid_argument if a trace holds a marker it did not declare
+    SimulationStats run();
+
+    explicit Simulator(const SimConfig& _config);
+private:
+    // cache of the next core, set up from the configuration and connected to the bus
+    Memory* create_memory();
+
+    SimConfig config;
+    Bus bus;
+    MemoryController memory_controller;
+    MeshInterconnect mesh;
+    CPU cpu;
+    int num_cores;
+    // by core, for the cores added by add_pushed_core
+    std::unordered_map<int, std::unique_ptr<BatchQueue>> queues;
+    InterleavingLog* recording;
+    const InterleavingLog* replaying;
+};
+
+#endif //SIMULATOR_H
@@ -0,0 +1,104 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "enums.h"
+#include "prefetcher.h"
+#include "store_buffer.h"
+#include "mshr.h"
+#include "victim_cache.h"
+#include "tlb.h"
+#include "dram.h"
+#include "mesh.h"
+#include "host_perf.h"
+
+struct AtomicStats {
+    // atomic read-modify-writes, and those that had to take the line from another core
+    long atomics = 0;
+    long contended = 0;
+    // latency of atomics, including the drain of pending stores and misses before them
+    long long cycles = 0;
+    long long max_cycles = 0;
+    // fence instructions and the cycles they stalled
+    long fences = 0;
+    long long fence_cycles = 0;
+};
+
+struct CoreStats {
+    long long cycles = 0;
+    long long idle_cycles = 0;
+    long long compute_cycles = 0;
+    long loads = 0;
+    long stores = 0;
+    long cache_hits = 0;
+    long cache_misses = 0;
+    long sets_allocated = 0;
+    long num_sets = 0;
+    // configuration of the core's private cache, which can differ between cores
+    int cache_size = 0;
+    int associativity = 0;
+    int cache_hit_time = 0;
+    // instructions run in the fast mode, during warm-up or outside the regions of interest
+    long fast_forwarded = 0;
+
+    // feature stats are only meaningful when the feature is enabled on the core
+    bool has_prefetcher = false;
+    PrefetchStats prefetch;
+    bool has_store_buffer = false;
+    StoreBufferStats store_buffer;
+    bool has_mshrs = false;
+    MSHRStats mshr;
+    bool has_victim_cache = false;
+    VictimCacheStats victim_cache;
+    bool has_tlb = false;
+    TLBStats tlb;
+    AtomicStats atomic;
+};
+
+struct DRAMStats {
+    PagePolicy page_policy = OpenPage;
+    int num_channels = 0;
+    int num_banks = 0;
+    // indexed by channel * num_banks + bank
+    std::vector<BankStats> banks;
+};
+
+// results of a simulation run
+struct SimulationStats {
+    std::vector<CoreStats> cores;
+    long long total_traffic = 0;
+    long total_invalidations_updates = 0;
+    long private_accesses = 0;
+    long shared_accesses = 0;
+    bool has_dram = false;
+    DRAMStats dram;
+    // interconnect and last-level cache stats of a mesh, in place of the bus
+    bool has_mesh = false;
+    MeshStats mesh;
+    // wall clock time of the run on the host
+    long long host_time_ms = 0;
+    long long host_time_ns = 0;
+    // host hardware counters per host thread, when requested; host_perf_error says why they are missing
+    bool has_host_perf = false;
+    std::vector<HostCounters> host_threads;
+    std::string host_perf_error;
+
+    // memory accesses simulated by all cores
+    [[nodiscard]] long long get_simulated_accesses() const {
+        long long accesses = 0;
+        for (const CoreStats& core : cores) accesses += core.loads + core.stores + core.atomic.atomics;
+        return accesses;
+    }
+
+    // cycles of the slowest core
+    [[nodiscard]] long long get_overall_cycles() const {
+        long long max_cycles = 0;
+        for (const CoreStats& core : cores) max_cycles = std::max(max_cycles, core.cycles);
+        return max_cycles;
+    }
+};
+
+#endif //STATS_H
@@ -0,0 +1,38 @@
+#include "store_buffer.h"
+
+StoreBuffer::StoreBuffer(int _capacity) : capacity(_capacity) {}
+
+bool StoreBuffer::contains(uint32_t block_address) const {
+    // the buffer is small, so a linear search is cheaper than keeping an index
+    for (const Entry& entry : entries) {
+        if (entry.block_address == block_address) return true;
+    }
+    return false;
+}
+
+bool StoreBuffer::holds_store_to(uint32_t address) const {
+    for (const Entry& entry : entries) {
+        if (entry.address == address) return true;
+    }
+    return false;
+}
+
+bool StoreBuffer::is_full() const {
+    return entries.size() >= static_cast<size_t>(capacity);
+}
+
+bool StoreBuffer::is_empty() const {
+    return entries.empty();
+}
+
+void StoreBuffer::push(uint32_t block_address, uint32_t address, long long cycle) {
+    entries.push_back(Entry{block_address, address, cycle});
+}
+
+const StoreBuffer::Entry& StoreBuffer::front() const {
+    return entries.front();
+}
+
+void StoreBuffer::pop() {
+    entries.pop_front();
+}
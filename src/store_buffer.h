@@ -0,0 +1,48 @@
+#ifndef STORE_BUFFER_H
+#define STORE_BUFFER_H
+
+#include <cstdint>
+#include <deque>
+
+struct StoreBufferStats {
+    // stores retired into the buffer
+    long stores = 0;
+    // stores merged into an entry already holding their block
+    long coalesced = 0;
+    // loads served from the buffer
+    long forwarded = 0;
+    // stores that found the buffer full, and the cycles they waited for a slot
+    long full_stalls = 0;
+    long long full_stall_cycles = 0;
+    // cycles spent waiting for the buffer to drain at fences
+    long long fence_stall_cycles = 0;
+};
+
+// FIFO of retired stores waiting to be written into the cache, one entry per block
+class StoreBuffer {
+public:
+    struct Entry {
+        uint32_t block_address;
+        uint32_t address;
+        // cycle at which the store was retired into the buffer
+        long long cycle;
+    };
+
+    // returns true if a buffered store covers the block
+    [[nodiscard]] bool contains(uint32_t block_address) const;
+    // returns true if an entry was opened by a store to exactly this address; the buffer holds no data, so the
+    // other addresses of a block, including those of stores coalesced into its entry, cannot be forwarded
+    [[nodiscard]] bool holds_store_to(uint32_t address) const;
+    [[nodiscard]] bool is_full() const;
+    [[nodiscard]] bool is_empty() const;
+    void push(uint32_t block_address, uint32_t address, long long cycle);
+    [[nodiscard]] const Entry& front() const;
+    void pop();
+
+    explicit StoreBuffer(int _capacity);
+private:
+    int capacity;
+    std::deque<Entry> entries;
+};
+
+#endif //STORE_BUFFER_H
@@ -0,0 +1,157 @@
+#include <cmath>
+
+#include "synthetic_trace.h"
+#include "config.h"
+
+SyntheticTrace::SyntheticTrace(SyntheticPattern _pattern, int _core, long long _length, uint64_t seed)
+        : pattern(_pattern), core(_core), length(_length), generated(0),
+          private_base(static_cast<uint32_t>(_core) * Config::SYNTHETIC_FOOTPRINT % Config::SYNTHETIC_SHARED_BASE), cursor(0), pending_position(0),
+          zipf_objects(Config::SYNTHETIC_FOOTPRINT / Config::SYNTHETIC_OBJECT_SIZE), zipf_zetan(0), zipf_alpha(0), zipf_eta(0) {
+    // every core gets its own stream, derived from the shared seed
+    std::seed_seq seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32), static_cast<uint32_t>(_core)};
+    rng.seed(seq);
+
+    if (pattern == Zipfian) {
+        // Gray et al., "Quickly generating billion-record synthetic databases"
+        const double theta = Config::SYNTHETIC_ZIPF_THETA;
+        for (uint32_t i = 1; i <= zipf_objects; i++) zipf_zetan += 1.0 / std::pow(i, theta);
+        double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+        zipf_alpha = 1.0 / (1.0 - theta);
+        zipf_eta = (1.0 - std::pow(2.0 / zipf_objects, 1.0 - theta)) / (1.0 - zeta2 / zipf_zetan);
+    }
+}
+
+bool SyntheticTrace::parse_pattern(const std::string& name, SyntheticPattern& pattern) {
+    if (name == "sequential") pattern = Sequential;
+    else if (name == "strided") pattern = Strided;
+    else if (name == "uniform") pattern = Uniform;
+    else if (name == "zipfian") pattern = Zipfian;
+    else if (name == "producer-consumer") pattern = ProducerConsumer;
+    else if (name == "migratory") pattern = Migratory;
+    else if (name == "lock") pattern = LockContention;
+    else return false;
+    return true;
+}
+
+std::string SyntheticTrace::get_pattern_str(SyntheticPattern pattern) {
+    switch (pattern) {
+    case Sequential:
+        return "sequential";
+    case Strided:
+        return "strided";
+    case Uniform:
+        return "uniform";
+    case Zipfian:
+        return "zipfian";
+    case ProducerConsumer:
+        return "producer-consumer";
+    case Migratory:
+        return "migratory";
+    case LockContention:
+        return "lock";
+    default:
+        return "";
+    }
+}
+
+const Instruction& SyntheticTrace::get_current_instruction() {
+    if (generated >= length) {
+        throw std::out_of_range("No further instructions available.");
+    }
+    if (pending_position == pending.size()) {
+        pending.clear();
+        pending_position = 0;
+        generate();
+    }
+    generated++;
+    return pending[pending_position++];
+}
+
+bool SyntheticTrace::has_next_instruction() const {
+    return generated < length;
+}
+
+void SyntheticTrace::push(InstructionType type, uint32_t value) {
+    pending.push_back(Instruction{type, static_cast<int>(value)});
+}
+
+void SyntheticTrace::push_compute() {
+    push(OTHER, 1 + static_cast<uint32_t>(rng() % Config::SYNTHETIC_MAX_COMPUTE));
+}
+
+bool SyntheticTrace::is_store() {
+    return static_cast<int>(rng() % 100) < Config::SYNTHETIC_STORE_PERCENT;
+}
+
+uint32_t SyntheticTrace::zipf_object() {
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    double uz = u * zipf_zetan;
+    if (uz < 1.0) return 0;
+    if (uz < 1.0 + std::pow(0.5, Config::SYNTHETIC_ZIPF_THETA)) return 1;
+    auto rank = static_cast<uint32_t>(zipf_objects * std::pow(zipf_eta * u - zipf_eta + 1.0, zipf_alpha));
+    return rank < zipf_objects ? rank : zipf_objects - 1;
+}
+
+void SyntheticTrace::generate() {
+    const uint32_t shared_base = Config::SYNTHETIC_SHARED_BASE;
+    const uint32_t object_size = Config::SYNTHETIC_OBJECT_SIZE;
+    const uint32_t words_per_object = object_size / 4;
+
+    switch (pattern) {
+    case Sequential: {
+        push(is_store() ? STORE : LOAD, private_base + cursor);
+        cursor = (cursor + 4) % Config::SYNTHETIC_FOOTPRINT;
+        break;
+    }
+    case Strided: {
+        push(is_store() ? STORE : LOAD, private_base + cursor);
+        cursor = (cursor + Config::SYNTHETIC_STRIDE) % Config::SYNTHETIC_FOOTPRINT;
+        break;
+    }
+    case Uniform: {
+        uint32_t word = static_cast<uint32_t>(rng() % (Config::SYNTHETIC_FOOTPRINT / 4));
+        push(is_store() ? STORE : LOAD, private_base + word * 4);
+        break;
+    }
+    case Zipfian: {
+        uint32_t word = static_cast<uint32_t>(rng() % words_per_object);
+        push(is_store() ? STORE : LOAD, private_base + zipf_object() * object_size + word * 4);
+        break;
+    }
+    case ProducerConsumer: {
+        // cores are paired on a shared buffer: the even core of a pair writes it, the odd core reads it
+        uint32_t buffer = shared_base + static_cast<uint32_t>(core / 2) * Config::SYNTHETIC_SHARED_SIZE;
+        push(core % 2 == 0 ? STORE : LOAD, buffer + cursor);
+        cursor = (cursor + 4) % Config::SYNTHETIC_SHARED_SIZE;
+        break;
+    }
+    case Migratory: {
+        // read-modify-write of a shared object, so each object moves from core to core
+        uint32_t object = static_cast<uint32_t>(rng() % Config::SYNTHETIC_MIGRATORY_OBJECTS);
+        uint32_t address = shared_base + object * object_size;
+        push(LOAD, address);
+        push_compute();
+        push(STORE, address);
+        break;
+    }
+    case LockContention: {
+        // spin on a single lock and take it atomically, update the data it protects, release it and
+        // do some private work
+        uint32_t lock = shared_base;
+        uint32_t data = shared_base + object_size;
+        int spins = 1 + static_cast<int>(rng() % Config::SYNTHETIC_MAX_SPINS);
+        for (int i = 0; i < spins; i++) push(LOAD, lock);
+        push(ATOMIC, lock);
+        for (int i = 0; i < Config::SYNTHETIC_CRITICAL_SECTION; i++) {
+            push(LOAD, data + static_cast<uint32_t>(i) * 4);
+            push(STORE, data + static_cast<uint32_t>(i) * 4);
+        }
+        push(FENCE, 0);
+        push(STORE, lock);
+        push(LOAD, private_base + cursor);
+        cursor = (cursor + 4) % Config::SYNTHETIC_FOOTPRINT;
+        break;
+    }
+    }
+    push_compute();
+}
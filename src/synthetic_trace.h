@@ -0,0 +1,54 @@
+#ifndef SYNTHETIC_TRACE_H
+#define SYNTHETIC_TRACE_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+#include "enums.h"
+
+// a trace generated on the fly from an access pattern, so that runs need no trace files and no I/O;
+// the same pattern, core and seed always produce the same instructions
+class SyntheticTrace : public Trace {
+public:
+    const Instruction& get_current_instruction() override;
+    bool has_next_instruction() const override;
+
+    // parse a pattern name as given on the command line: returns false if it is unknown
+    static bool parse_pattern(const std::string& name, SyntheticPattern& pattern);
+    static std::string get_pattern_str(SyntheticPattern pattern);
+
+    SyntheticTrace(SyntheticPattern _pattern, int _core, long long _length, uint64_t seed);
+private:
+    // append the next group of instructions of the pattern (e.g. a lock acquire and release) to pending
+    void generate();
+    void push(InstructionType type, uint32_t value);
+    void push_compute();
+    bool is_store();
+    // rank of an object drawn from a Zipfian distribution over the private footprint
+    uint32_t zipf_object();
+
+    SyntheticPattern pattern;
+    int core;
+    long long length;
+    long long generated;
+    std::mt19937_64 rng;
+    // base of the private region of the core; with more than 1024 cores the regions wrap around
+    uint32_t private_base;
+    // position of the sequential, strided and producer-consumer streams
+    uint32_t cursor;
+
+    // instructions generated but not returned yet; the storage is reused between groups
+    std::vector<Instruction> pending;
+    size_t pending_position;
+
+    // constants of the Zipfian generator, computed once for the footprint
+    uint32_t zipf_objects;
+    double zipf_zetan;
+    double zipf_alpha;
+    double zipf_eta;
+};
+
+#endif // SYNTHETIC_TRACE_H
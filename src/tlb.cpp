@@ -0,0 +1,23 @@
+#include "tlb.h"
+
+TLB::TLB(int _max_size) : max_size(_max_size) {}
+
+bool TLB::lookup(uint32_t page) {
+    auto map_iter = map.find(page);
+    if (map_iter == map.end()) return false;
+
+    pages.splice(pages.begin(), pages, map_iter->second);
+    return true;
+}
+
+void TLB::insert(uint32_t page) {
+    if (lookup(page)) return;
+
+    if (pages.size() == static_cast<size_t>(max_size)) {
+        map.erase(pages.back());
+        pages.pop_back();
+    }
+
+    pages.push_front(page);
+    map[page] = pages.begin();
+}
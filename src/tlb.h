@@ -0,0 +1,37 @@
+#ifndef TLB_H
+#define TLB_H
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+struct TLBStats {
+    // translations served by the L1 TLB, the L2 TLB, or neither (page walks)
+    long l1_hits = 0;
+    long l2_hits = 0;
+    long misses = 0;
+    // cycles spent in L2 TLB lookups and page walks
+    long long cycles = 0;
+    long long walk_cycles = 0;
+    // page table entries read by page walks, and how many of them hit in the cache
+    long walk_accesses = 0;
+    long walk_cache_hits = 0;
+};
+
+// fully associative LRU TLB holding virtual page numbers; translations are identity mapped,
+// so only the presence of a page matters
+class TLB {
+public:
+    // returns true if the page is held, making it the most recently used
+    bool lookup(uint32_t page);
+    // insert a page, pushing out the least recently used one if the TLB is full
+    void insert(uint32_t page);
+
+    explicit TLB(int _max_size);
+private:
+    int max_size;
+    std::list<uint32_t> pages;
+    std::unordered_map<uint32_t, std::list<uint32_t>::iterator> map;
+};
+
+#endif //TLB_H
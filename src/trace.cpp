@@ -2,6 +2,8 @@
 
 Trace::Trace() : current_instruction(0) {}
 
+Trace::Trace(std::vector<Instruction> _data) : data(std::move(_data)), current_instruction(0) {}
+
 bool Trace::read_data(const std::string& filename) {
     std::ifstream infile(filename);
     if (!infile) {
@@ -14,68 +16,89 @@ bool Trace::read_data(const std::string& filename) {
     int line_number = 0;
     while (std::getline(infile, line)) {
         line_number++;
-        if (line.empty()) continue;
+        Instruction ins;
+        if (parse_line(line, line_number, ins)) data.emplace_back(ins);
+    }
 
-        std::istringstream iss(line);
-        std::string type_str;
-        std::string value_str;
+    infile.close();
 
-        if (!(iss >> type_str >> value_str)) {
-            std::cerr << "Error: Invalid format at line " << line_number << ": '"
-                      << line << "'. Skipping." << std::endl;
-            continue;
-        }
+    if (data.empty()) {
+        std::cerr << "Warning: No valid instructions loaded from '" << filename << "'." << std::endl;
+        return false;
+    }
 
-        if (type_str == "//") {
-            continue;
-        }
+    std::cout << "Successfully loaded " << data.size() << " instructions from '" << filename << "'." << std::endl;
+    return true;
+}
 
-        int type_int = std::stoi(type_str);
-        InstructionType type;
-        switch (type_int) {
-        case 0:
-            type = LOAD;
-            break;
-        case 1:
-            type = STORE;
-            break;
-        case 2:
-            type = OTHER;
-            break;
-        default:
-            std::cerr << "Warning: Unknown instruction type " << type_int
-                      << " at line " << line_number << ". Skipping." << std::endl;
-            continue;
-        }
+bool Trace::parse_line(const std::string& line, int line_number, Instruction& ins) {
+    if (line.empty()) return false;
 
-        int value;
-        try {
-            if (value_str.find("0x") == 0) {
-                value = std::stoi(value_str.substr(2), nullptr, 16);
-            } else {
-                value = std::stoi(value_str, nullptr, 16);
-            }
-        } catch (const std::invalid_argument& e) {
-            std::cerr << "Error: Invalid hexadecimal value '" << value_str
-                      << "' at line " << line_number << ". Skipping." << std::endl;
-            continue;
-        } catch (const std::out_of_range& e) {
-            std::cerr << "Error: Hexadecimal value out of range '" << value_str
-                      << "' at line " << line_number << ". Skipping." << std::endl;
-            continue;
-        }
+    std::istringstream iss(line);
+    std::string type_str;
+    std::string value_str;
 
-        data.emplace_back(Instruction{type, value});
+    if (!(iss >> type_str >> value_str)) {
+        std::cerr << "Error: Invalid format at line " << line_number << ": '"
+                  << line << "'. Skipping." << std::endl;
+        return false;
     }
 
-    infile.close();
+    if (type_str == "//") {
+        return false;
+    }
 
-    if (data.empty()) {
-        std::cerr << "Warning: No valid instructions loaded from '" << filename << "'." << std::endl;
+    int type_int = std::stoi(type_str);
+    InstructionType type;
+    switch (type_int) {
+    case 0:
+        type = LOAD;
+        break;
+    case 1:
+        type = STORE;
+        break;
+    case 2:
+        type = OTHER;
+        break;
+    case 3:
+        type = ATOMIC;
+        break;
+    case 4:
+        type = FENCE;
+        break;
+    case 5:
+        type = ROI_BEGIN;
+        break;
+    case 6:
+        type = ROI_END;
+        break;
+    case 7:
+        type = WARMUP_END;
+        break;
+    default:
+        std::cerr << "Warning: Unknown instruction type " << type_int
+                  << " at line " << line_number << ". Skipping." << std::endl;
         return false;
     }
 
-    std::cout << "Successfully loaded " << data.size() << " instructions from '" << filename << "'." << std::endl;
+    int value;
+    try {
+        if (value_str.find("0x") == 0) {
+            value = std::stoi(value_str.substr(2), nullptr, 16);
+        } else {
+            value = std::stoi(value_str, nullptr, 16);
+        }
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "Error: Invalid hexadecimal value '" << value_str
+                  << "' at line " << line_number << ". Skipping." << std::endl;
+        return false;
+    } catch (const std::out_of_range& e) {
+        std::cerr << "Error: Hexadecimal value out of range '" << value_str
+                  << "' at line " << line_number << ". Skipping." << std::endl;
+        return false;
+    }
+
+    ins = Instruction{type, value};
     return true;
 }
 
@@ -90,3 +113,15 @@ const Instruction& Trace::get_current_instruction() {
 bool Trace::has_next_instruction() const {
     return current_instruction < data.size();
 }
+
+const std::vector<Instruction>& Trace::get_instructions() const {
+    return data;
+}
+
+TraceMarkers Trace::get_markers() const {
+    return find_markers(data.data(), data.size());
+}
+
+std::span<const std::byte> Trace::get_storage() const {
+    return std::as_bytes(std::span<const Instruction>(data));
+}
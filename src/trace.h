@@ -1,6 +1,8 @@
 #ifndef TRACE_H
 #define TRACE_H
 
+#include <cstddef>
+#include <span>
 #include <vector>
 #include <string>
 #include <fstream>
@@ -10,7 +12,16 @@
 enum InstructionType {
     LOAD,
     STORE,
-    OTHER
+    OTHER,
+    // atomic read-modify-write (e.g. CAS, fetch-and-add) on an address
+    ATOMIC,
+    // memory fence, value unused
+    FENCE,
+    // markers, value unused: stats are only collected inside regions of interest if a trace has any,
+    // and everything before the end of warm-up only warms the caches
+    ROI_BEGIN,
+    ROI_END,
+    WARMUP_END
 };
 
 struct Instruction {
@@ -18,13 +29,48 @@ struct Instruction {
     int value;
 };
 
+// whether an instruction of this type accesses memory at the address in its value
+inline bool is_memory_access(InstructionType type) {
+    return type == LOAD || type == STORE || type == ATOMIC;
+}
+
+// the markers a trace holds, known before it runs
+struct TraceMarkers {
+    bool warmup = false;
+    bool roi = false;
+};
+
+template <typename Ins>
+TraceMarkers find_markers(const Ins* instructions, size_t count) {
+    TraceMarkers markers;
+    for (size_t i = 0; i < count; i++) {
+        markers.warmup = markers.warmup || instructions[i].type == WARMUP_END;
+        markers.roi = markers.roi || instructions[i].type == ROI_BEGIN;
+    }
+    return markers;
+}
+
 class Trace {
 public:
     Trace();
+    // a trace of instructions already in memory
+    explicit Trace(std::vector<Instruction> _data);
     bool read_data(const std::string& filename);
+    // parse one line of a trace file: returns false, after reporting any problem, if it holds no instruction
+    static bool parse_line(const std::string& line, int line_number, Instruction& ins);
+
+    virtual const Instruction& get_current_instruction();
+    virtual bool has_next_instruction() const;
+    // instructions read from file; empty for traces generated on the fly
+    const std::vector<Instruction>& get_instructions() const;
+    // markers of the whole trace, known before it runs; traces generated on the fly have none, and streamed
+    // traces hold only the markers they declare
+    virtual TraceMarkers get_markers() const;
+    // memory holding the instructions, so that it can be placed near the thread running the trace;
+    // empty for traces generated on the fly
+    virtual std::span<const std::byte> get_storage() const;
 
-    const Instruction& get_current_instruction();
-    bool has_next_instruction() const;
+    virtual ~Trace() = default;
 
 private:
     std::vector<Instruction> data;
@@ -0,0 +1,40 @@
+#include "victim_cache.h"
+#include "cache.h"
+
+VictimCache::VictimCache(int _max_size) : max_size(_max_size) {}
+
+CacheState VictimCache::remove(uint32_t block_address) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto map_iter = map.find(block_address);
+    if (map_iter == map.end()) return NotPresent;
+
+    CacheState state = map_iter->second->second;
+    lines.erase(map_iter->second);
+    map.erase(map_iter);
+    return state;
+}
+
+std::pair<uint32_t, CacheState> VictimCache::insert(uint32_t block_address, CacheState state) {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::pair<uint32_t, CacheState> evicted = {0, NotPresent};
+
+    if (lines.size() == static_cast<size_t>(max_size)) {
+        // push out the least recently inserted line
+        evicted = lines.back();
+        lines.pop_back();
+        map.erase(evicted.first);
+    }
+
+    lines.push_front({block_address, state});
+    map[block_address] = lines.begin();
+    return evicted;
+}
+
+BusResponse VictimCache::process_signal_from_bus(uint32_t block_address, BusMessage message, Bus* bus, int sender_idx) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto map_iter = map.find(block_address);
+    if (map_iter == map.end()) return NoResponse;
+
+    // lines in the victim cache follow the same protocol as lines in the main cache
+    return LRUSet::snoop(map_iter->second->second, message, bus, block_address, sender_idx);
+}
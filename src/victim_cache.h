@@ -0,0 +1,44 @@
+#ifndef VICTIM_CACHE_H
+#define VICTIM_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "enums.h"
+
+class Bus;
+
+struct VictimCacheStats {
+    // main cache misses served from the victim cache
+    long hits = 0;
+    // cycles those hits saved over fetching the block on the bus
+    long long cycles_saved = 0;
+    // lines evicted from the main cache into the victim cache
+    long insertions = 0;
+    // dirty lines written back when they left the victim cache
+    long write_backs = 0;
+};
+
+// small fully associative LRU cache holding lines evicted from the main cache, indexed by block address
+class VictimCache {
+public:
+    // take the line out of the victim cache: returns its state, or NotPresent if it is not held
+    CacheState remove(uint32_t block_address);
+    // insert an evicted line: returns the {block address, state} pushed out to make room
+    std::pair<uint32_t, CacheState> insert(uint32_t block_address, CacheState state);
+    // process bus signal according to protocol
+    BusResponse process_signal_from_bus(uint32_t block_address, BusMessage message, Bus* bus, int sender_idx);
+
+    explicit VictimCache(int _max_size);
+private:
+    std::mutex mtx;
+    int max_size;
+    // list of pairs of {block address, state}
+    std::list<std::pair<uint32_t, CacheState>> lines;
+    // map from block address to iterator pointing to the pair of {block address, state} in the list of lines
+    std::unordered_map<uint32_t, std::list<std::pair<uint32_t, CacheState>>::iterator> map;
+};
+
+#endif //VICTIM_CACHE_H